@@ -0,0 +1,212 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// frame_window selects the events accumulated in a frame.
+    enum class frame_window {
+        /// time accumulates consecutive time windows, length being the window duration in timestamp units.
+        /// The windows start with the first event, and each frame is stamped with its window's end.
+        /// The empty windows of a gap between events are skipped.
+        time,
+
+        /// count accumulates consecutive groups of length events.
+        count,
+
+        /// sliding accumulates the last length events, and passes a frame every hop events.
+        sliding,
+    };
+
+    /// frame_view points to a frame passed by accumulate_frame, which remains valid until the next frame.
+    /// The frame holds two planes (off events, then on events) of width * height pixels in row-major order.
+    /// Each plane starts on a 64 bytes boundary, stride pixels after the previous one.
+    template <typename Pixel>
+    struct frame_view {
+        uint64_t t;
+        uint16_t width;
+        uint16_t height;
+        std::size_t stride;
+        const Pixel* pixels;
+
+        /// at returns the given pixel.
+        Pixel at(bool polarity, uint16_t x, uint16_t y) const {
+            return pixels[(polarity ? stride : 0) + x + y * width];
+        }
+    };
+
+    /// accumulate_frame counts the events of each pixel and polarity, and passes the frames to handle_frame.
+    /// Pixel can be an unsigned integer type or a floating point type. Integer counts saturate, and a saturated pixel
+    /// undercounts once events leave a sliding window.
+    /// The frames are double-buffered: the frame being accumulated and the last frame passed to handle_frame are
+    /// preallocated, and swapped when a frame is completed. A new frame is cleared with memset, which the standard
+    /// library implements with vector instructions.
+    /// When decay is larger than 0 (floating point pixels only, and not with sliding windows), the frames are not
+    /// cleared. Instead, each pixel is scaled by exp(-delta_t / decay) when it receives an event, and all the pixels
+    /// are brought up to date before a frame is passed.
+    template <typename Event, typename Pixel, typename HandleFrame>
+    class accumulate_frame {
+        public:
+        accumulate_frame(
+            uint16_t width,
+            uint16_t height,
+            frame_window window,
+            uint64_t length,
+            uint64_t hop,
+            float decay,
+            HandleFrame&& handle_frame) :
+            _width(width),
+            _height(height),
+            _window(window),
+            _length(length),
+            _hop(hop),
+            _decay(decay),
+            _handle_frame(std::forward<HandleFrame>(handle_frame)),
+            _stride(
+                (static_cast<std::size_t>(width) * height + 64 / sizeof(Pixel) - 1) / (64 / sizeof(Pixel))
+                * (64 / sizeof(Pixel))),
+            _storage(_stride * 4 + 64 / sizeof(Pixel) - 1, Pixel{}),
+            _ts(decay > 0 ? _stride * 2 : 0, 0),
+            _sliding_indices(window == frame_window::sliding ? length : 0, 0),
+            _active(0),
+            _count(0),
+            _next_t(0),
+            _started(false) {
+            if (_length == 0) {
+                throw std::logic_error("length must be larger than 0");
+            }
+            if (_window == frame_window::sliding && _hop == 0) {
+                throw std::logic_error("hop must be larger than 0");
+            }
+            if (_decay < 0) {
+                throw std::logic_error("decay must be larger than or equal to 0");
+            }
+            if (_decay > 0 && (!std::is_floating_point<Pixel>::value || _window == frame_window::sliding)) {
+                throw std::logic_error("decay must be 0 with integer pixels or sliding windows");
+            }
+            _offset = static_cast<std::size_t>(
+                (64 - reinterpret_cast<std::uintptr_t>(_storage.data()) % 64) % 64 / sizeof(Pixel));
+        }
+        accumulate_frame(const accumulate_frame&) = delete;
+        accumulate_frame(accumulate_frame&&) = default;
+        accumulate_frame& operator=(const accumulate_frame&) = delete;
+        accumulate_frame& operator=(accumulate_frame&&) = default;
+        virtual ~accumulate_frame() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            if (_window == frame_window::time) {
+                if (!_started) {
+                    _started = true;
+                    _next_t = event.t + _length;
+                } else if (event.t >= _next_t) {
+                    pass(_next_t);
+                    // the windows stay aligned on the first event, hence a gap skips whole windows
+                    _next_t += ((event.t - _next_t) / _length + 1) * _length;
+                }
+            }
+            const auto index = (event.polarity ? _stride : 0) + event.x + event.y * _width;
+            auto frame = active();
+            if (_decay > 0) {
+                frame[index] *= std::exp(-static_cast<float>(event.t - _ts[index]) / _decay);
+                _ts[index] = event.t;
+            }
+            if (frame[index] < std::numeric_limits<Pixel>::max()) {
+                frame[index] += 1;
+            }
+            switch (_window) {
+                case frame_window::time:
+                    break;
+                case frame_window::count:
+                    ++_count;
+                    if (_count == _length) {
+                        _count = 0;
+                        pass(event.t);
+                    }
+                    break;
+                case frame_window::sliding: {
+                    auto& sliding_index = _sliding_indices[_count % _length];
+                    if (_count >= _length && frame[sliding_index] > 0) {
+                        frame[sliding_index] -= 1;
+                    }
+                    sliding_index = static_cast<uint32_t>(index);
+                    ++_count;
+                    if (_count % _hop == 0) {
+                        pass(event.t);
+                    }
+                    break;
+                }
+            }
+        }
+
+        protected:
+        /// active returns the frame being accumulated.
+        Pixel* active() {
+            return _storage.data() + _offset + _active * _stride * 2;
+        }
+
+        /// pass hands the frame being accumulated to handle_frame, and swaps the frames.
+        void pass(uint64_t t) {
+            auto frame = active();
+            if (_decay > 0) {
+                for (std::size_t index = 0; index < _ts.size(); ++index) {
+                    frame[index] *= std::exp(-static_cast<float>(t - _ts[index]) / _decay);
+                    _ts[index] = t;
+                }
+            }
+            _handle_frame(frame_view<Pixel>{t, _width, _height, _stride, frame});
+            _active = 1 - _active;
+            if (_decay > 0 || _window == frame_window::sliding) {
+                std::copy(frame, frame + _stride * 2, active());
+            } else {
+                std::memset(active(), 0, _stride * 2 * sizeof(Pixel));
+            }
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const frame_window _window;
+        const uint64_t _length;
+        const uint64_t _hop;
+        const float _decay;
+        HandleFrame _handle_frame;
+        const std::size_t _stride;
+        std::vector<Pixel> _storage;
+        std::vector<uint64_t> _ts;
+        std::vector<uint32_t> _sliding_indices;
+        std::size_t _offset;
+        std::size_t _active;
+        uint64_t _count;
+        uint64_t _next_t;
+        bool _started;
+    };
+
+    /// make_accumulate_frame creates an accumulate_frame from functors.
+    template <typename Event, typename Pixel, typename HandleFrame>
+    inline accumulate_frame<Event, Pixel, HandleFrame> make_accumulate_frame(
+        uint16_t width,
+        uint16_t height,
+        frame_window window,
+        uint64_t length,
+        uint64_t hop,
+        float decay,
+        HandleFrame&& handle_frame) {
+        return accumulate_frame<Event, Pixel, HandleFrame>(
+            width,
+            height,
+            window,
+            length,
+            hop,
+            decay,
+            std::forward<HandleFrame>(handle_frame));
+    }
+}
@@ -1,12 +1,40 @@
 #pragma once
 
+#include "state.hpp"
 #include <stdexcept>
 #include <utility>
 #include <vector>
 #include <cmath>
+#include <cstdint>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
+    /// grid_centers copies the centers of a grid's cells row by row, as used by the grids' save_state.
+    template <typename Grid>
+    inline std::vector<float> grid_centers(const Grid& grid) {
+        std::vector<float> centers;
+        for (const auto& row : grid) {
+            for (const auto& cell : row) {
+                centers.push_back(cell.cx);
+                centers.push_back(cell.cy);
+            }
+        }
+        return centers;
+    }
+
+    /// set_grid_centers restores the centers copied by grid_centers.
+    template <typename Grid>
+    inline void set_grid_centers(Grid& grid, const std::vector<float>& centers) {
+        std::size_t index = 0;
+        for (auto& row : grid) {
+            for (auto& cell : row) {
+                cell.cx = centers[index];
+                cell.cy = centers[index + 1];
+                index += 2;
+            }
+        }
+    }
+
     /// average_grid calculates the average positions of the given events within each grid.
     /// An exponential event-wise decay is used as weight.
     template <typename Event, typename Grid, typename EventToGrid, typename HandleGrid>
@@ -44,6 +72,22 @@ namespace tarsier {
             _handle_grid(_event_to_grid(event, _grid, ir, ic));
         }
 
+        /// save_state writes the handler's state to a stream.
+        /// Only the cells' centers are saved, since their validity is a parameter.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "average_grid");
+            state_format::write_buffer(stream, grid_centers(_grid));
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "average_grid");
+            auto centers = grid_centers(_grid);
+            state_format::read_buffer(stream, centers);
+            set_grid_centers(_grid, centers);
+        }
+
         protected:
         Grid _grid;
         const float _pitch;
@@ -67,4 +111,104 @@ namespace tarsier {
             std::forward<EventToGrid>(event_to_grid),
             std::forward<HandleGrid>(handle_grid));
     }
+
+    /// temporal_average_grid calculates the average positions of the given events within each grid.
+    /// An exponential time-wise decay is used as weight: each cell's previous average is weighted by
+    /// exp(-delta_t / decay), where delta_t is the time elapsed since the cell's previous event.
+    /// If output_period is not 0, the grid is passed at most once per period.
+    template <typename Event, typename Grid, typename EventToGrid, typename HandleGrid>
+    class temporal_average_grid {
+        public:
+        temporal_average_grid(
+            Grid grid,
+            float pitch,
+            float decay,
+            uint64_t output_period,
+            EventToGrid&& event_to_grid,
+            HandleGrid&& handle_grid) :
+            _grid(grid),
+            _pitch(pitch),
+            _decay(decay),
+            _output_period(output_period),
+            _event_to_grid(std::forward<EventToGrid>(event_to_grid)),
+            _handle_grid(std::forward<HandleGrid>(handle_grid)),
+            _columns(_grid.size() > 0 ? _grid[0].size() : 0),
+            _ts(_grid.size() * _columns, 0),
+            _next_output_t(0) {
+            if (!(_decay > 0)) {
+                throw std::logic_error("decay must be larger than 0");
+            }
+        }
+        temporal_average_grid(const temporal_average_grid&) = delete;
+        temporal_average_grid(temporal_average_grid&&) = default;
+        temporal_average_grid& operator=(const temporal_average_grid&) = delete;
+        temporal_average_grid& operator=(temporal_average_grid&&) = default;
+        virtual ~temporal_average_grid() {}
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const uint16_t ic = std::floor(event.x / _pitch);
+            const uint16_t ir = std::floor(event.y / _pitch);
+            if (_grid[ir][ic].valid) {
+                auto& t = _ts[ir * _columns + ic];
+                const auto inertia = std::exp(-static_cast<float>(event.t - t) / _decay);
+                t = event.t;
+                _grid[ir][ic].cx = inertia * _grid[ir][ic].cx + (1 - inertia) * event.x;
+                _grid[ir][ic].cy = inertia * _grid[ir][ic].cy + (1 - inertia) * event.y;
+            }
+            if (event.t >= _next_output_t) {
+                _next_output_t = event.t + _output_period;
+                _handle_grid(_event_to_grid(event, _grid, ir, ic));
+            }
+        }
+
+        /// save_state writes the handler's state to a stream.
+        /// Only the cells' centers are saved, since their validity is a parameter.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "temporal_average_grid");
+            state_format::write_buffer(stream, grid_centers(_grid));
+            state_format::write_buffer(stream, _ts);
+            state_format::write_value(stream, _next_output_t);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "temporal_average_grid");
+            auto centers = grid_centers(_grid);
+            state_format::read_buffer(stream, centers);
+            state_format::read_buffer(stream, _ts);
+            state_format::read_value(stream, _next_output_t);
+            set_grid_centers(_grid, centers);
+        }
+
+        protected:
+        Grid _grid;
+        const float _pitch;
+        const float _decay;
+        const uint64_t _output_period;
+        EventToGrid _event_to_grid;
+        HandleGrid _handle_grid;
+        const std::size_t _columns;
+        std::vector<uint64_t> _ts;
+        uint64_t _next_output_t;
+    };
+
+    /// make_temporal_average_grid creates a temporal_average_grid from functors.
+    template <typename Event, typename Grid, typename EventToGrid, typename HandleGrid>
+    inline temporal_average_grid<Event, Grid, EventToGrid, HandleGrid> make_temporal_average_grid(
+        Grid grid,
+        float pitch,
+        float decay,
+        uint64_t output_period,
+        EventToGrid&& event_to_grid,
+        HandleGrid&& handle_grid) {
+        return temporal_average_grid<Event, Grid, EventToGrid, HandleGrid>(
+            grid,
+            pitch,
+            decay,
+            output_period,
+            std::forward<EventToGrid>(event_to_grid),
+            std::forward<HandleGrid>(handle_grid));
+    }
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "state.hpp"
+#include <cmath>
+#include <cstdint>
 #include <stdexcept>
 #include <utility>
 
@@ -38,6 +41,21 @@ namespace tarsier {
             _handle_position(_event_to_position(event, _x, _y));
         }
 
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "average_position");
+            state_format::write_value(stream, _x);
+            state_format::write_value(stream, _y);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "average_position");
+            state_format::read_value(stream, _x);
+            state_format::read_value(stream, _y);
+        }
+
         protected:
         float _x;
         float _y;
@@ -61,4 +79,97 @@ namespace tarsier {
             std::forward<EventToPosition>(EventToposition),
             std::forward<HandlePosition>(handle_position));
     }
+
+    /// temporal_average_position calculates the average position of the given events.
+    /// An exponential time-wise decay is used as weight: the previous average is weighted by exp(-delta_t / decay),
+    /// where delta_t is the time elapsed since the previous event, hence the time constant does not depend
+    /// on the event rate. The initial position is weighted as if it was set at t = 0.
+    /// If output_period is not 0, the position is passed at most once per period.
+    template <typename Event, typename Position, typename EventToPosition, typename HandlePosition>
+    class temporal_average_position {
+        public:
+        temporal_average_position(
+            float x,
+            float y,
+            float decay,
+            uint64_t output_period,
+            EventToPosition&& event_to_position,
+            HandlePosition&& handle_position) :
+            _x(x),
+            _y(y),
+            _decay(decay),
+            _output_period(output_period),
+            _event_to_position(std::forward<EventToPosition>(event_to_position)),
+            _handle_position(std::forward<HandlePosition>(handle_position)),
+            _previous_t(0),
+            _next_output_t(0) {
+            if (!(_decay > 0)) {
+                throw std::logic_error("decay must be larger than 0");
+            }
+        }
+        temporal_average_position(const temporal_average_position&) = delete;
+        temporal_average_position(temporal_average_position&&) = default;
+        temporal_average_position& operator=(const temporal_average_position&) = delete;
+        temporal_average_position& operator=(temporal_average_position&&) = default;
+        virtual ~temporal_average_position() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto inertia = std::exp(-static_cast<float>(event.t - _previous_t) / _decay);
+            _previous_t = event.t;
+            _x = inertia * _x + (1 - inertia) * event.x;
+            _y = inertia * _y + (1 - inertia) * event.y;
+            if (event.t >= _next_output_t) {
+                _next_output_t = event.t + _output_period;
+                _handle_position(_event_to_position(event, _x, _y));
+            }
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "temporal_average_position");
+            state_format::write_value(stream, _x);
+            state_format::write_value(stream, _y);
+            state_format::write_value(stream, _previous_t);
+            state_format::write_value(stream, _next_output_t);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "temporal_average_position");
+            state_format::read_value(stream, _x);
+            state_format::read_value(stream, _y);
+            state_format::read_value(stream, _previous_t);
+            state_format::read_value(stream, _next_output_t);
+        }
+
+        protected:
+        float _x;
+        float _y;
+        const float _decay;
+        const uint64_t _output_period;
+        EventToPosition _event_to_position;
+        HandlePosition _handle_position;
+        uint64_t _previous_t;
+        uint64_t _next_output_t;
+    };
+
+    /// make_temporal_average_position creates a temporal_average_position from functors.
+    template <typename Event, typename Position, typename EventToPosition, typename HandlePosition>
+    inline temporal_average_position<Event, Position, EventToPosition, HandlePosition> make_temporal_average_position(
+        float x,
+        float y,
+        float decay,
+        uint64_t output_period,
+        EventToPosition&& event_to_position,
+        HandlePosition&& handle_position) {
+        return temporal_average_position<Event, Position, EventToPosition, HandlePosition>(
+            x,
+            y,
+            decay,
+            output_period,
+            std::forward<EventToPosition>(event_to_position),
+            std::forward<HandlePosition>(handle_position));
+    }
 }
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "state.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// cluster_statistics summarizes the events of a cluster since its creation.
+    struct cluster_statistics {
+        uint64_t first_t;
+        uint64_t last_t;
+        uint64_t events;
+        float x;
+        float y;
+        uint16_t left;
+        uint16_t top;
+        uint16_t right;
+        uint16_t bottom;
+    };
+
+    /// cluster_events groups the events into connected components, without a predefined number of clusters.
+    /// An event joins the clusters of its 8 neighbours that received an event within temporal_window, and the
+    /// clusters it touches are merged with a union-find (union by size, path halving).
+    /// event_to_cluster is called for each event with the label and the statistics of its cluster, which are updated
+    /// incrementally. A merged cluster takes the label of the largest of its parts.
+    /// The labels, in the range [1, capacity], are recycled once their cluster has not received events for
+    /// temporal_window. An event that would start a new cluster while every label is in use is ignored.
+    /// All the storage is allocated on construction.
+    template <typename Event, typename Cluster, typename EventToCluster, typename HandleCluster>
+    class cluster_events {
+        public:
+        cluster_events(
+            uint16_t width,
+            uint16_t height,
+            uint64_t temporal_window,
+            uint32_t capacity,
+            EventToCluster&& event_to_cluster,
+            HandleCluster&& handle_cluster) :
+            _width(width),
+            _height(height),
+            _temporal_window(temporal_window),
+            _capacity(capacity),
+            _event_to_cluster(std::forward<EventToCluster>(event_to_cluster)),
+            _handle_cluster(std::forward<HandleCluster>(handle_cluster)),
+            _pixels(width * height, pixel{0, 0}),
+            _parents(capacity + 1),
+            _statistics(capacity + 1, cluster_statistics{0, 0, 0, 0.0f, 0.0f, 0, 0, 0, 0}),
+            _next_label(0),
+            _exhausted_until_t(0) {
+            if (_capacity == 0) {
+                throw std::logic_error("capacity must be larger than 0");
+            }
+            for (uint32_t label = 0; label <= _capacity; ++label) {
+                _parents[label] = label;
+            }
+        }
+        cluster_events(const cluster_events&) = delete;
+        cluster_events(cluster_events&&) = default;
+        cluster_events& operator=(const cluster_events&) = delete;
+        cluster_events& operator=(cluster_events&&) = default;
+        virtual ~cluster_events() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            uint32_t label = 0;
+            const auto x_begin = event.x > 0 ? event.x - 1 : 0;
+            const auto x_end = event.x < _width - 1 ? event.x + 1 : _width - 1;
+            const auto y_begin = event.y > 0 ? event.y - 1 : 0;
+            const auto y_end = event.y < _height - 1 ? event.y + 1 : _height - 1;
+            for (auto y = y_begin; y <= y_end; ++y) {
+                for (auto x = x_begin; x <= x_end; ++x) {
+                    const auto& neighbour = _pixels[x + y * _width];
+                    if (neighbour.label > 0 && neighbour.t + _temporal_window > event.t) {
+                        const auto root = find(neighbour.label);
+                        if (label == 0) {
+                            label = root;
+                        } else if (root != label) {
+                            label = merge(label, root);
+                        }
+                    }
+                }
+            }
+            if (label == 0) {
+                label = allocate(event.t);
+                if (label == 0) {
+                    return;
+                }
+            }
+            auto& event_pixel = _pixels[event.x + event.y * _width];
+            event_pixel.t = event.t;
+            event_pixel.label = label;
+            auto& statistics = _statistics[label];
+            ++statistics.events;
+            statistics.last_t = event.t;
+            statistics.x += (event.x - statistics.x) / statistics.events;
+            statistics.y += (event.y - statistics.y) / statistics.events;
+            statistics.left = std::min(statistics.left, static_cast<uint16_t>(event.x));
+            statistics.top = std::min(statistics.top, static_cast<uint16_t>(event.y));
+            statistics.right = std::max(statistics.right, static_cast<uint16_t>(event.x));
+            statistics.bottom = std::max(statistics.bottom, static_cast<uint16_t>(event.y));
+            _handle_cluster(_event_to_cluster(event, label, static_cast<const cluster_statistics&>(statistics)));
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "cluster_events");
+            state_format::write_field(stream, _pixels, &pixel::t);
+            state_format::write_field(stream, _pixels, &pixel::label);
+            state_format::write_buffer(stream, _parents);
+            state_format::write_buffer(stream, _statistics);
+            state_format::write_value(stream, _next_label);
+            state_format::write_value(stream, _exhausted_until_t);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "cluster_events");
+            state_format::read_field(stream, _pixels, &pixel::t);
+            state_format::read_field(stream, _pixels, &pixel::label);
+            state_format::read_buffer(stream, _parents);
+            state_format::read_buffer(stream, _statistics);
+            state_format::read_value(stream, _next_label);
+            state_format::read_value(stream, _exhausted_until_t);
+        }
+
+        protected:
+        /// pixel stores the label and timestamp of a pixel's last event.
+        struct pixel {
+            uint64_t t;
+            uint32_t label;
+        };
+
+        /// find returns the label of a cluster's root, and halves the path on the way.
+        uint32_t find(uint32_t label) {
+            while (_parents[label] != label) {
+                _parents[label] = _parents[_parents[label]];
+                label = _parents[label];
+            }
+            return label;
+        }
+
+        /// merge joins two roots, and returns the surviving one.
+        uint32_t merge(uint32_t first, uint32_t second) {
+            if (_statistics[first].events < _statistics[second].events) {
+                std::swap(first, second);
+            }
+            _parents[second] = first;
+            auto& statistics = _statistics[first];
+            const auto& absorbed = _statistics[second];
+            const auto events = statistics.events + absorbed.events;
+            statistics.x = (statistics.x * statistics.events + absorbed.x * absorbed.events) / events;
+            statistics.y = (statistics.y * statistics.events + absorbed.y * absorbed.events) / events;
+            statistics.events = events;
+            statistics.first_t = std::min(statistics.first_t, absorbed.first_t);
+            statistics.last_t = std::max(statistics.last_t, absorbed.last_t);
+            statistics.left = std::min(statistics.left, absorbed.left);
+            statistics.top = std::min(statistics.top, absorbed.top);
+            statistics.right = std::max(statistics.right, absorbed.right);
+            statistics.bottom = std::max(statistics.bottom, absorbed.bottom);
+            return first;
+        }
+
+        /// allocate returns a free label, or 0 if every label is in use.
+        /// A label is free if it was never used, or if its cluster has not received events for temporal_window.
+        /// The labels are scanned in a round-robin order, hence the oldest labels are recycled first.
+        /// A failed scan records the earliest time a label may be freed, so that the following events do not scan
+        /// the labels again before that time.
+        uint32_t allocate(uint64_t t) {
+            if (t < _exhausted_until_t) {
+                return 0;
+            }
+            auto exhausted_until_t = std::numeric_limits<uint64_t>::max();
+            for (uint32_t attempt = 0; attempt < _capacity; ++attempt) {
+                const auto label = _next_label + 1;
+                _next_label = label % _capacity;
+                const auto& root_statistics = _statistics[find(label)];
+                if (root_statistics.events == 0 || root_statistics.last_t + _temporal_window <= t) {
+                    _parents[label] = label;
+                    _statistics[label] = cluster_statistics{t, t, 0, 0.0f, 0.0f, 0xffff, 0xffff, 0, 0};
+                    return label;
+                }
+                exhausted_until_t = std::min(exhausted_until_t, root_statistics.last_t + _temporal_window);
+            }
+            _exhausted_until_t = exhausted_until_t;
+            return 0;
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint64_t _temporal_window;
+        const uint32_t _capacity;
+        EventToCluster _event_to_cluster;
+        HandleCluster _handle_cluster;
+        std::vector<pixel> _pixels;
+        std::vector<uint32_t> _parents;
+        std::vector<cluster_statistics> _statistics;
+        uint32_t _next_label;
+        uint64_t _exhausted_until_t;
+    };
+
+    /// make_cluster_events creates a cluster_events from functors.
+    template <typename Event, typename Cluster, typename EventToCluster, typename HandleCluster>
+    inline cluster_events<Event, Cluster, EventToCluster, HandleCluster> make_cluster_events(
+        uint16_t width,
+        uint16_t height,
+        uint64_t temporal_window,
+        uint32_t capacity,
+        EventToCluster&& event_to_cluster,
+        HandleCluster&& handle_cluster) {
+        return cluster_events<Event, Cluster, EventToCluster, HandleCluster>(
+            width,
+            height,
+            temporal_window,
+            capacity,
+            std::forward<EventToCluster>(event_to_cluster),
+            std::forward<HandleCluster>(handle_cluster));
+    }
+}
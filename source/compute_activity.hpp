@@ -1,5 +1,6 @@
 #pragma once
 
+#include "state.hpp"
 #include <cmath>
 #include <cstdint>
 #include <utility>
@@ -38,6 +39,21 @@ namespace tarsier {
             _handle_activity(_event_to_activity(event, potential_and_t.first));
         }
 
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "compute_activity");
+            state_format::write_field(stream, _potentials_and_ts, &std::pair<float, uint64_t>::first);
+            state_format::write_field(stream, _potentials_and_ts, &std::pair<float, uint64_t>::second);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "compute_activity");
+            state_format::read_field(stream, _potentials_and_ts, &std::pair<float, uint64_t>::first);
+            state_format::read_field(stream, _potentials_and_ts, &std::pair<float, uint64_t>::second);
+        }
+
         protected:
         const uint16_t _width;
         const float _decay;
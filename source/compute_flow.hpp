@@ -1,5 +1,6 @@
 #pragma once
 
+#include "state.hpp"
 #include <cmath>
 #include <cstdint>
 #include <utility>
@@ -92,6 +93,19 @@ namespace tarsier {
             }
         }
 
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "compute_flow");
+            state_format::write_buffer(stream, _ts);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "compute_flow");
+            state_format::read_buffer(stream, _ts);
+        }
+
         protected:
         /// point represents a point in xyt space.
         struct point {
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "compute_time_surface.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// hats_time_surface bundles an event and its time surface, as passed from compute_time_surface to
+    /// hats_accumulator.
+    template <typename Event, uint16_t spatial_window>
+    struct hats_time_surface {
+        Event event;
+        std::array<std::pair<float, bool>, (spatial_window * 2 + 1) * (spatial_window * 2 + 1)>
+            projections_and_polarities;
+    };
+
+    /// hats_event_to_time_surface creates a hats_time_surface.
+    template <typename Event, uint16_t spatial_window>
+    struct hats_event_to_time_surface {
+        hats_time_surface<Event, spatial_window> operator()(
+            Event event,
+            const std::array<std::pair<float, bool>, (spatial_window * 2 + 1) * (spatial_window * 2 + 1)>&
+                projections_and_polarities) const {
+            return {event, projections_and_polarities};
+        }
+    };
+
+    /// hats_accumulator sums the time surfaces of the events of each cell and polarity.
+    /// The histograms are stored contiguously, and each one starts on a 64 bytes boundary.
+    /// When decay is larger than 0, each histogram is scaled by exp(-delta_t / decay) when it receives
+    /// a new contribution, so that the decay costs nothing for the cells without events.
+    template <typename Event, uint16_t spatial_window>
+    class hats_accumulator {
+        public:
+        /// projections_size is the number of values in a time surface.
+        static constexpr std::size_t projections_size = (spatial_window * 2 + 1) * (spatial_window * 2 + 1);
+
+        /// stride is the number of floats between two histograms.
+        static constexpr std::size_t stride = (projections_size + 15) / 16 * 16;
+
+        hats_accumulator(uint16_t width, uint16_t height, uint16_t cell_size, float decay) :
+            _cell_size(cell_size),
+            _columns(cell_size == 0 ? 0 : (width - 1) / cell_size + 1),
+            _rows(cell_size == 0 ? 0 : (height - 1) / cell_size + 1),
+            _decay(decay),
+            _storage(_columns * _rows * 2 * stride + 15, 0.0f),
+            _counts(_columns * _rows * 2, 0.0f),
+            _ts(_columns * _rows * 2, 0) {
+            if (cell_size == 0) {
+                throw std::logic_error("cell_size must be larger than 0");
+            }
+            _offset = static_cast<std::size_t>(
+                (64 - reinterpret_cast<std::uintptr_t>(_storage.data()) % 64) % 64 / sizeof(float));
+        }
+        hats_accumulator(const hats_accumulator&) = delete;
+        hats_accumulator(hats_accumulator&&) = default;
+        hats_accumulator& operator=(const hats_accumulator&) = delete;
+        hats_accumulator& operator=(hats_accumulator&&) = default;
+        virtual ~hats_accumulator() = default;
+
+        /// operator() handles a time surface.
+        virtual void operator()(const hats_time_surface<Event, spatial_window>& time_surface) {
+            const auto polarity = static_cast<bool>(time_surface.event.polarity);
+            const auto index =
+                (time_surface.event.x / _cell_size + (time_surface.event.y / _cell_size) * _columns) * 2
+                + (polarity ? 1 : 0);
+            auto histogram = _storage.data() + _offset + index * stride;
+            if (_decay > 0) {
+                const auto factor =
+                    std::exp(-static_cast<float>(time_surface.event.t - _ts[index]) / _decay);
+                _ts[index] = time_surface.event.t;
+                if (factor < 1.0f) {
+                    for (std::size_t projection_index = 0; projection_index < projections_size; ++projection_index) {
+                        histogram[projection_index] *= factor;
+                    }
+                    _counts[index] *= factor;
+                }
+            }
+            for (std::size_t projection_index = 0; projection_index < projections_size; ++projection_index) {
+                const auto& projection_and_polarity = time_surface.projections_and_polarities[projection_index];
+                if (projection_and_polarity.second == polarity) {
+                    histogram[projection_index] += projection_and_polarity.first;
+                }
+            }
+            _counts[index] += 1.0f;
+        }
+
+        /// size returns the number of values in the feature vector.
+        std::size_t size() const {
+            return _counts.size() * projections_size;
+        }
+
+        /// features writes the histograms, each divided by its number of events, in cell-major order
+        /// (cell, then polarity, then projection). Pending decays cancel out in the normalization.
+        void features(std::vector<float>& output) const {
+            output.resize(size());
+            auto output_iterator = output.begin();
+            for (std::size_t index = 0; index < _counts.size(); ++index) {
+                const auto histogram = _storage.data() + _offset + index * stride;
+                const auto inverse_count = _counts[index] > 0 ? 1.0f / _counts[index] : 0.0f;
+                for (std::size_t projection_index = 0; projection_index < projections_size; ++projection_index) {
+                    *output_iterator = histogram[projection_index] * inverse_count;
+                    ++output_iterator;
+                }
+            }
+        }
+
+        /// reset clears the histograms.
+        void reset() {
+            std::fill(_storage.begin(), _storage.end(), 0.0f);
+            std::fill(_counts.begin(), _counts.end(), 0.0f);
+            std::fill(_ts.begin(), _ts.end(), 0);
+        }
+
+        protected:
+        const uint16_t _cell_size;
+        const std::size_t _columns;
+        const std::size_t _rows;
+        const float _decay;
+        std::vector<float> _storage;
+        std::vector<float> _counts;
+        std::vector<uint64_t> _ts;
+        std::size_t _offset;
+    };
+
+    /// compute_hats computes histograms of averaged time surfaces (HATS).
+    /// The sensor is divided in square cells, and each cell accumulates, for each polarity,
+    /// the time surfaces generated by its events. Only the projections with the event's polarity
+    /// contribute to a histogram. The time surfaces are computed by compute_time_surface,
+    /// and the feature vector can be retrieved at any time.
+    /// histogram_decay controls the lazy decay of old contributions, and 0 disables it.
+    template <typename Event, uint16_t spatial_window>
+    class compute_hats : public compute_time_surface<
+                             Event,
+                             bool,
+                             hats_time_surface<Event, spatial_window>,
+                             spatial_window,
+                             hats_event_to_time_surface<Event, spatial_window>,
+                             hats_accumulator<Event, spatial_window>> {
+        public:
+        compute_hats(
+            uint16_t width,
+            uint16_t height,
+            uint16_t cell_size,
+            uint64_t temporal_window,
+            float decay,
+            float histogram_decay) :
+            compute_time_surface<
+                Event,
+                bool,
+                hats_time_surface<Event, spatial_window>,
+                spatial_window,
+                hats_event_to_time_surface<Event, spatial_window>,
+                hats_accumulator<Event, spatial_window>>(
+                width,
+                height,
+                temporal_window,
+                decay,
+                hats_event_to_time_surface<Event, spatial_window>(),
+                hats_accumulator<Event, spatial_window>(width, height, cell_size, histogram_decay)) {}
+        compute_hats(const compute_hats&) = delete;
+        compute_hats(compute_hats&&) = default;
+        compute_hats& operator=(const compute_hats&) = delete;
+        compute_hats& operator=(compute_hats&&) = default;
+        virtual ~compute_hats() = default;
+
+        /// size returns the number of values in the feature vector.
+        std::size_t size() const {
+            return this->_handle_time_surface.size();
+        }
+
+        /// features writes the normalized histograms in output, which is resized if needed.
+        void features(std::vector<float>& output) const {
+            this->_handle_time_surface.features(output);
+        }
+
+        /// reset clears the timestamps and the histograms, to process a new sample.
+        void reset() {
+            std::fill(
+                this->_ts_and_polarities.begin(),
+                this->_ts_and_polarities.end(),
+                std::pair<uint64_t, bool>(0, false));
+            this->_handle_time_surface.reset();
+        }
+    };
+
+    /// make_compute_hats creates a compute_hats.
+    template <typename Event, uint16_t spatial_window>
+    inline compute_hats<Event, spatial_window> make_compute_hats(
+        uint16_t width,
+        uint16_t height,
+        uint16_t cell_size,
+        uint64_t temporal_window,
+        float decay,
+        float histogram_decay) {
+        return compute_hats<Event, spatial_window>(width, height, cell_size, temporal_window, decay, histogram_decay);
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "state.hpp"
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// compute_pyramid_flow evaluates the optical flow on several downsampled timestamp maps.
+    /// Level l divides the coordinates by 2^l, so that a small spatial window at a coarse level
+    /// covers fast motions while the per-event cost stays constant.
+    /// A downsampled pixel keeps the timestamp of an event in its area until that timestamp is older than
+    /// temporal_window, even if events keep arriving, and then takes the next event's timestamp. Hence an edge
+    /// crossing the area is timestamped consistently.
+    /// A plane is fitted at each level as in compute_flow, and the levels' time gradients are averaged
+    /// with inverse-variance weights. The variance accounts for the fit residuals and for the timestamps'
+    /// quantization, hence coarse levels prevail for fast motions, whose fine timestamps differ by a few ticks.
+    /// Degenerate fits are ignored, and an event whose levels are all degenerate produces no output.
+    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
+    class compute_pyramid_flow {
+        public:
+        compute_pyramid_flow(
+            uint16_t width,
+            uint16_t height,
+            uint8_t levels,
+            uint16_t spatial_window,
+            uint64_t temporal_window,
+            std::size_t minimum_number_of_events,
+            EventToFlow&& event_to_flow,
+            HandleFlow&& handle_flow) :
+            _spatial_window(spatial_window),
+            _temporal_window(temporal_window),
+            _minimum_number_of_events(minimum_number_of_events),
+            _event_to_flow(std::forward<EventToFlow>(event_to_flow)),
+            _handle_flow(std::forward<HandleFlow>(handle_flow)) {
+            if (levels == 0 || levels > 16) {
+                throw std::logic_error("levels must be in the range [1, 16]");
+            }
+            std::size_t size = 0;
+            for (uint8_t index = 0; index < levels; ++index) {
+                const level new_level{
+                    static_cast<uint16_t>(((width - 1) >> index) + 1),
+                    static_cast<uint16_t>(((height - 1) >> index) + 1),
+                    size,
+                };
+                size += static_cast<std::size_t>(new_level.width) * new_level.height;
+                _levels.push_back(new_level);
+            }
+            _ts.resize(size, 0);
+        }
+        compute_pyramid_flow(const compute_pyramid_flow&) = delete;
+        compute_pyramid_flow(compute_pyramid_flow&&) = default;
+        compute_pyramid_flow& operator=(const compute_pyramid_flow&) = delete;
+        compute_pyramid_flow& operator=(compute_pyramid_flow&&) = default;
+        virtual ~compute_pyramid_flow() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
+            auto x_gradient_sum = 0.0;
+            auto y_gradient_sum = 0.0;
+            auto weights_sum = 0.0;
+            for (std::size_t index = 0; index < _levels.size(); ++index) {
+                const auto& level = _levels[index];
+                const uint16_t level_x = event.x >> index;
+                const uint16_t level_y = event.y >> index;
+                const auto ts = _ts.data() + level.offset;
+                auto& level_t = ts[level_x + level_y * level.width];
+                if (index == 0 || level_t <= t_threshold) {
+                    level_t = event.t;
+                }
+                auto n = 0.0;
+                auto t_sum = 0.0;
+                auto x_sum = 0.0;
+                auto y_sum = 0.0;
+                auto tt_sum = 0.0;
+                auto tx_sum = 0.0;
+                auto ty_sum = 0.0;
+                auto xx_sum = 0.0;
+                auto xy_sum = 0.0;
+                auto yy_sum = 0.0;
+                const uint16_t left = level_x <= _spatial_window ? 0 : level_x - _spatial_window;
+                const uint16_t bottom = level_y <= _spatial_window ? 0 : level_y - _spatial_window;
+                const uint16_t right =
+                    level_x >= level.width - 1 - _spatial_window ? level.width - 1 : level_x + _spatial_window;
+                const uint16_t top =
+                    level_y >= level.height - 1 - _spatial_window ? level.height - 1 : level_y + _spatial_window;
+                for (uint16_t y = bottom; y <= top; ++y) {
+                    for (uint16_t x = left; x <= right; ++x) {
+                        const auto t = ts[x + y * level.width];
+                        if (t > t_threshold) {
+                            // coordinates are relative to the event, which keeps the raw moments small
+                            const auto t_delta = -static_cast<double>(event.t - t);
+                            const auto x_delta = static_cast<double>(x) - level_x;
+                            const auto y_delta = static_cast<double>(y) - level_y;
+                            n += 1;
+                            t_sum += t_delta;
+                            x_sum += x_delta;
+                            y_sum += y_delta;
+                            tt_sum += t_delta * t_delta;
+                            tx_sum += t_delta * x_delta;
+                            ty_sum += t_delta * y_delta;
+                            xx_sum += x_delta * x_delta;
+                            xy_sum += x_delta * y_delta;
+                            yy_sum += y_delta * y_delta;
+                        }
+                    }
+                }
+                if (n < _minimum_number_of_events) {
+                    continue;
+                }
+                tt_sum -= t_sum * t_sum / n;
+                tx_sum -= t_sum * x_sum / n;
+                ty_sum -= t_sum * y_sum / n;
+                xx_sum -= x_sum * x_sum / n;
+                xy_sum -= x_sum * y_sum / n;
+                yy_sum -= y_sum * y_sum / n;
+                const auto t_determinant = xx_sum * yy_sum - xy_sum * xy_sum;
+                if (!(t_determinant > 0)) {
+                    continue;
+                }
+                const auto x_gradient = (tx_sum * yy_sum - ty_sum * xy_sum) / t_determinant;
+                const auto y_gradient = (ty_sum * xx_sum - tx_sum * xy_sum) / t_determinant;
+                const auto residuals = tt_sum - x_gradient * tx_sum - y_gradient * ty_sum;
+                const auto variance = (residuals > 0 ? residuals / n : 0.0) + quantization_variance;
+                const auto scale = static_cast<double>(1 << index);
+                const auto weight = scale * scale * t_determinant / (variance * (xx_sum + yy_sum));
+                x_gradient_sum += weight * x_gradient / scale;
+                y_gradient_sum += weight * y_gradient / scale;
+                weights_sum += weight;
+            }
+            if (weights_sum > 0) {
+                const auto x_gradient = x_gradient_sum / weights_sum;
+                const auto y_gradient = y_gradient_sum / weights_sum;
+                const auto squared_norm = x_gradient * x_gradient + y_gradient * y_gradient;
+                if (squared_norm > 0) {
+                    const auto vx = static_cast<float>(x_gradient / squared_norm);
+                    const auto vy = static_cast<float>(y_gradient / squared_norm);
+                    if (std::isfinite(vx) && std::isfinite(vy)) {
+                        _handle_flow(_event_to_flow(event, vx, vy));
+                    }
+                }
+            }
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "compute_pyramid_flow");
+            state_format::write_buffer(stream, _ts);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "compute_pyramid_flow");
+            state_format::read_buffer(stream, _ts);
+        }
+
+        protected:
+        /// quantization_variance is the variance of the timestamps' rounding to integers.
+        static constexpr double quantization_variance = 1.0 / 12.0;
+
+        /// level represents a downsampled timestamp map.
+        struct level {
+            uint16_t width;
+            uint16_t height;
+            std::size_t offset;
+        };
+
+        const uint16_t _spatial_window;
+        const uint64_t _temporal_window;
+        const std::size_t _minimum_number_of_events;
+        EventToFlow _event_to_flow;
+        HandleFlow _handle_flow;
+        std::vector<level> _levels;
+        std::vector<uint64_t> _ts;
+    };
+
+    /// make_compute_pyramid_flow creates a compute_pyramid_flow from functors.
+    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
+    inline compute_pyramid_flow<Event, Flow, EventToFlow, HandleFlow> make_compute_pyramid_flow(
+        uint16_t width,
+        uint16_t height,
+        uint8_t levels,
+        uint16_t spatial_window,
+        uint64_t temporal_window,
+        std::size_t minimum_number_of_events,
+        EventToFlow&& event_to_flow,
+        HandleFlow&& handle_flow) {
+        return compute_pyramid_flow<Event, Flow, EventToFlow, HandleFlow>(
+            width,
+            height,
+            levels,
+            spatial_window,
+            temporal_window,
+            minimum_number_of_events,
+            std::forward<EventToFlow>(event_to_flow),
+            std::forward<HandleFlow>(handle_flow));
+    }
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include "state.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// flow_mode lists the outputs of compute_sparse_flow.
+    enum class flow_mode {
+        /// normal outputs the flow orthogonal to the local edge (aperture-normal), as compute_flow does.
+        normal,
+
+        /// full combines the recent normal flows in the spatial window into a full flow vector.
+        full,
+    };
+
+    /// compute_sparse_flow evaluates the optical flow with the same plane fit as compute_flow.
+    /// The fit's sums are updated incrementally when the event falls inside the previous window
+    /// and no point left the temporal window, so that only the window's moving borders are scanned.
+    /// Degenerate fits are rejected with a conditioning test, and produce no output.
+    /// conditioning is the minimum ratio between the eigenvalues of the fit's matrix, in the range [0, 1].
+    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
+    class compute_sparse_flow {
+        public:
+        compute_sparse_flow(
+            uint16_t width,
+            uint16_t height,
+            uint16_t spatial_window,
+            uint64_t temporal_window,
+            std::size_t minimum_number_of_events,
+            float conditioning,
+            flow_mode mode,
+            EventToFlow&& event_to_flow,
+            HandleFlow&& handle_flow) :
+            _width(width),
+            _height(height),
+            _spatial_window(spatial_window),
+            _temporal_window(temporal_window),
+            _minimum_number_of_events(minimum_number_of_events),
+            _determinant_ratio(conditioning / ((1 + conditioning) * (1 + conditioning))),
+            _mode(mode),
+            _event_to_flow(std::forward<EventToFlow>(event_to_flow)),
+            _handle_flow(std::forward<HandleFlow>(handle_flow)),
+            _ts(width * height, 0),
+            _normal_flows(mode == flow_mode::full ? width * height : 0, normal_flow{0.0f, 0.0f, 0}),
+            _window{1, 1, 0, 0},
+            _sums{},
+            _t_reference(0),
+            _oldest_t(0),
+            _incremental_updates(0) {
+            if (conditioning < 0 || conditioning > 1) {
+                throw std::logic_error("conditioning must be in the range [0, 1]");
+            }
+        }
+        compute_sparse_flow(const compute_sparse_flow&) = delete;
+        compute_sparse_flow(compute_sparse_flow&&) = default;
+        compute_sparse_flow& operator=(const compute_sparse_flow&) = delete;
+        compute_sparse_flow& operator=(compute_sparse_flow&&) = default;
+        virtual ~compute_sparse_flow() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
+            const rectangle window{
+                static_cast<uint16_t>(event.x <= _spatial_window ? 0 : event.x - _spatial_window),
+                static_cast<uint16_t>(event.y <= _spatial_window ? 0 : event.y - _spatial_window),
+                static_cast<uint16_t>(
+                    event.x >= _width - 1 - _spatial_window ? _width - 1 : event.x + _spatial_window),
+                static_cast<uint16_t>(
+                    event.y >= _height - 1 - _spatial_window ? _height - 1 : event.y + _spatial_window),
+            };
+            if (_incremental_updates < maximum_incremental_updates && t_threshold < _oldest_t
+                && event.x >= _window.left && event.x <= _window.right && event.y >= _window.bottom
+                && event.y <= _window.top) {
+                ++_incremental_updates;
+                for_each_difference(_window, window, [&](uint16_t x, uint16_t y) {
+                    const auto t = _ts[x + y * _width];
+                    if (t > t_threshold) {
+                        _sums.remove(relative(t), x, y);
+                    }
+                });
+                for_each_difference(window, _window, [&](uint16_t x, uint16_t y) {
+                    const auto t = _ts[x + y * _width];
+                    if (t > t_threshold) {
+                        _sums.add(relative(t), x, y);
+                        _oldest_t = std::min(_oldest_t, t);
+                    }
+                });
+                const auto previous_t = _ts[event.x + event.y * _width];
+                if (previous_t > t_threshold) {
+                    _sums.remove(relative(previous_t), event.x, event.y);
+                }
+            } else {
+                _incremental_updates = 0;
+                _sums = sums{};
+                _t_reference = event.t;
+                _oldest_t = std::numeric_limits<uint64_t>::max();
+                for (uint16_t y = window.bottom; y <= window.top; ++y) {
+                    for (uint16_t x = window.left; x <= window.right; ++x) {
+                        if (x == event.x && y == event.y) {
+                            continue;
+                        }
+                        const auto t = _ts[x + y * _width];
+                        if (t > t_threshold) {
+                            _sums.add(relative(t), x, y);
+                            _oldest_t = std::min(_oldest_t, t);
+                        }
+                    }
+                }
+            }
+            _window = window;
+            _ts[event.x + event.y * _width] = event.t;
+            _sums.add(relative(event.t), event.x, event.y);
+            _oldest_t = std::min(_oldest_t, event.t);
+            if (_sums.n < _minimum_number_of_events) {
+                return;
+            }
+            const auto n = _sums.n;
+            const auto xx_sum = _sums.xx - _sums.x * _sums.x / n;
+            const auto xy_sum = _sums.xy - _sums.x * _sums.y / n;
+            const auto yy_sum = _sums.yy - _sums.y * _sums.y / n;
+            const auto tx_sum = _sums.tx - _sums.t * _sums.x / n;
+            const auto ty_sum = _sums.ty - _sums.t * _sums.y / n;
+            const auto t_determinant = xx_sum * yy_sum - xy_sum * xy_sum;
+            if (!is_well_conditioned(t_determinant, xx_sum + yy_sum)) {
+                return;
+            }
+            const auto x_determinant = tx_sum * yy_sum - ty_sum * xy_sum;
+            const auto y_determinant = ty_sum * xx_sum - tx_sum * xy_sum;
+            const auto squares_sum = x_determinant * x_determinant + y_determinant * y_determinant;
+            if (!(squares_sum > 0)) {
+                return;
+            }
+            const auto vx = static_cast<float>(t_determinant * x_determinant / squares_sum);
+            const auto vy = static_cast<float>(t_determinant * y_determinant / squares_sum);
+            if (!std::isfinite(vx) || !std::isfinite(vy)) {
+                return;
+            }
+            if (_mode == flow_mode::normal) {
+                _handle_flow(_event_to_flow(event, vx, vy));
+                return;
+            }
+            _normal_flows[event.x + event.y * _width] = normal_flow{vx, vy, event.t};
+            full_flow(event, window, t_threshold);
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "compute_sparse_flow");
+            state_format::write_buffer(stream, _ts);
+            state_format::write_buffer(stream, _normal_flows);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "compute_sparse_flow");
+            state_format::read_buffer(stream, _ts);
+            state_format::read_buffer(stream, _normal_flows);
+            // the running sums are recomputed on the next event
+            _window = rectangle{1, 1, 0, 0};
+        }
+
+        protected:
+        /// maximum_incremental_updates bounds the floating-point drift of the incremental sums.
+        static const uint32_t maximum_incremental_updates = 64;
+
+        /// rectangle represents a window, bounds included.
+        struct rectangle {
+            uint16_t left;
+            uint16_t bottom;
+            uint16_t right;
+            uint16_t top;
+        };
+
+        /// sums stores the raw moments of the points in the window.
+        struct sums {
+            double n;
+            double t;
+            double x;
+            double y;
+            double tx;
+            double ty;
+            double xx;
+            double xy;
+            double yy;
+
+            /// add includes a point.
+            void add(double point_t, double point_x, double point_y) {
+                n += 1;
+                t += point_t;
+                x += point_x;
+                y += point_y;
+                tx += point_t * point_x;
+                ty += point_t * point_y;
+                xx += point_x * point_x;
+                xy += point_x * point_y;
+                yy += point_y * point_y;
+            }
+
+            /// remove excludes a point.
+            void remove(double point_t, double point_x, double point_y) {
+                n -= 1;
+                t -= point_t;
+                x -= point_x;
+                y -= point_y;
+                tx -= point_t * point_x;
+                ty -= point_t * point_y;
+                xx -= point_x * point_x;
+                xy -= point_x * point_y;
+                yy -= point_y * point_y;
+            }
+        };
+
+        /// normal_flow stores the last normal flow computed at a pixel.
+        struct normal_flow {
+            float vx;
+            float vy;
+            uint64_t t;
+        };
+
+        /// for_each_difference calls handle_pixel for each pixel in first but not in second.
+        template <typename HandlePixel>
+        static void for_each_difference(rectangle first, rectangle second, HandlePixel handle_pixel) {
+            for (uint32_t y = first.bottom; y <= first.top; ++y) {
+                if (y < second.bottom || y > second.top) {
+                    for (uint32_t x = first.left; x <= first.right; ++x) {
+                        handle_pixel(static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+                    }
+                } else {
+                    for (uint32_t x = first.left; x <= first.right && x < second.left; ++x) {
+                        handle_pixel(static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+                    }
+                    for (uint32_t x = std::max(second.right + 1u, static_cast<uint32_t>(first.left)); x <= first.right;
+                         ++x) {
+                        handle_pixel(static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+                    }
+                }
+            }
+        }
+
+        /// is_well_conditioned checks that the ratio between the smallest and largest eigenvalues
+        /// of a symmetric positive 2x2 matrix is at least conditioning, without square roots.
+        /// The ratio r is related to the determinant and the trace by det / trace^2 = r / (1 + r)^2.
+        bool is_well_conditioned(double determinant, double trace) const {
+            return determinant > 0 && determinant >= _determinant_ratio * trace * trace;
+        }
+
+        /// relative returns a timestamp relative to the last full scan, which keeps the sums accurate.
+        double relative(uint64_t t) const {
+            return static_cast<double>(static_cast<int64_t>(t - _t_reference));
+        }
+
+        /// full_flow solves for the velocity compatible with the recent normal flows in the window.
+        /// Each normal flow u constrains the full flow v with v.u = |u|^2.
+        void full_flow(Event event, rectangle window, uint64_t t_threshold) {
+            auto uxux_sum = 0.0f;
+            auto uxuy_sum = 0.0f;
+            auto uyuy_sum = 0.0f;
+            auto uxb_sum = 0.0f;
+            auto uyb_sum = 0.0f;
+            for (uint16_t y = window.bottom; y <= window.top; ++y) {
+                for (uint16_t x = window.left; x <= window.right; ++x) {
+                    const auto& flow = _normal_flows[x + y * _width];
+                    if (flow.t > t_threshold) {
+                        const auto squared_norm = flow.vx * flow.vx + flow.vy * flow.vy;
+                        uxux_sum += flow.vx * flow.vx / squared_norm;
+                        uxuy_sum += flow.vx * flow.vy / squared_norm;
+                        uyuy_sum += flow.vy * flow.vy / squared_norm;
+                        uxb_sum += flow.vx;
+                        uyb_sum += flow.vy;
+                    }
+                }
+            }
+            const auto determinant = uxux_sum * uyuy_sum - uxuy_sum * uxuy_sum;
+            if (!is_well_conditioned(determinant, uxux_sum + uyuy_sum)) {
+                return;
+            }
+            _handle_flow(_event_to_flow(
+                event,
+                (uyuy_sum * uxb_sum - uxuy_sum * uyb_sum) / determinant,
+                (uxux_sum * uyb_sum - uxuy_sum * uxb_sum) / determinant));
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint16_t _spatial_window;
+        const uint64_t _temporal_window;
+        const std::size_t _minimum_number_of_events;
+        const double _determinant_ratio;
+        const flow_mode _mode;
+        EventToFlow _event_to_flow;
+        HandleFlow _handle_flow;
+        std::vector<uint64_t> _ts;
+        std::vector<normal_flow> _normal_flows;
+        rectangle _window;
+        sums _sums;
+        uint64_t _t_reference;
+        uint64_t _oldest_t;
+        uint32_t _incremental_updates;
+    };
+
+    /// make_compute_sparse_flow creates a compute_sparse_flow from functors.
+    template <typename Event, typename Flow, typename EventToFlow, typename HandleFlow>
+    inline compute_sparse_flow<Event, Flow, EventToFlow, HandleFlow> make_compute_sparse_flow(
+        uint16_t width,
+        uint16_t height,
+        uint16_t spatial_window,
+        uint64_t temporal_window,
+        std::size_t minimum_number_of_events,
+        float conditioning,
+        flow_mode mode,
+        EventToFlow&& event_to_flow,
+        HandleFlow&& handle_flow) {
+        return compute_sparse_flow<Event, Flow, EventToFlow, HandleFlow>(
+            width,
+            height,
+            spatial_window,
+            temporal_window,
+            minimum_number_of_events,
+            conditioning,
+            mode,
+            std::forward<EventToFlow>(event_to_flow),
+            std::forward<HandleFlow>(handle_flow));
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "state.hpp"
 #include <array>
 #include <cmath>
 #include <cstdint>
@@ -47,7 +48,7 @@ namespace tarsier {
             }
             const auto t_threshold = (event.t <= _temporal_window ? 0 : event.t - _temporal_window);
             std::array<std::pair<float, Polarity>, (spatial_window * 2 + 1) * (spatial_window * 2 + 1)>
-                projections_and_polarities;
+                projections_and_polarities{};
             for (uint16_t y = (event.y <= spatial_window ? 0 : event.y - spatial_window);
                  y <= (event.y >= _height - 1 - spatial_window ? _height - 1 : event.y + spatial_window);
                  ++y) {
@@ -66,6 +67,21 @@ namespace tarsier {
             _handle_time_surface(_event_to_time_surface(event, projections_and_polarities));
         }
 
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "compute_time_surface");
+            state_format::write_field(stream, _ts_and_polarities, &std::pair<uint64_t, Polarity>::first);
+            state_format::write_field(stream, _ts_and_polarities, &std::pair<uint64_t, Polarity>::second);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "compute_time_surface");
+            state_format::read_field(stream, _ts_and_polarities, &std::pair<uint64_t, Polarity>::first);
+            state_format::read_field(stream, _ts_and_polarities, &std::pair<uint64_t, Polarity>::second);
+        }
+
         protected:
         const uint16_t _width;
         const uint16_t _height;
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// voxel_grid_view points to a voxel grid passed by compute_voxel_grid, which remains valid until the next grid.
+    /// The values are stored contiguously in (bins, height, width) order, and start on a 64 bytes boundary.
+    struct voxel_grid_view {
+        uint64_t begin_t;
+        uint64_t end_t;
+        uint16_t bins;
+        uint16_t height;
+        uint16_t width;
+        const float* values;
+
+        /// at returns the given voxel.
+        float at(uint16_t bin, uint16_t x, uint16_t y) const {
+            return values[(static_cast<std::size_t>(bin) * height + y) * width + x];
+        }
+    };
+
+    /// compute_voxel_grid builds voxel grids, where each event adds its polarity (1 or -1) to the two bins nearest
+    /// to its timestamp, with bilinear temporal weights. The timestamps of a grid's window are mapped linearly
+    /// onto [0, bins - 1].
+    /// operator()(Event) builds grids over consecutive windows of the given duration. A window starts with its first
+    /// event, and its grid is passed when an event reaches the window's end.
+    /// operator()(begin, end) builds a single grid from a batch of events sorted by timestamp, whose window spans the
+    /// first and last timestamps, and passes it. The bins are split between threads, and each thread reads only the
+    /// events that contribute to its bins, hence the result does not depend on the number of threads.
+    /// The grid is allocated once and reused.
+    template <typename Event, typename HandleVoxelGrid>
+    class compute_voxel_grid {
+        public:
+        compute_voxel_grid(
+            uint16_t width,
+            uint16_t height,
+            uint16_t bins,
+            uint64_t duration,
+            std::size_t threads,
+            HandleVoxelGrid&& handle_voxel_grid) :
+            _width(width),
+            _height(height),
+            _bins(bins),
+            _duration(duration),
+            _threads(threads > 0 ? threads : std::max(std::thread::hardware_concurrency(), 1u)),
+            _handle_voxel_grid(std::forward<HandleVoxelGrid>(handle_voxel_grid)),
+            _size(static_cast<std::size_t>(width) * height * bins),
+            _storage(_size + 15, 0.0f),
+            _begin_t(0),
+            _started(false) {
+            if (_bins == 0) {
+                throw std::logic_error("bins must be larger than 0");
+            }
+            if (_duration == 0) {
+                throw std::logic_error("duration must be larger than 0");
+            }
+            _offset = static_cast<std::size_t>(
+                (64 - reinterpret_cast<std::uintptr_t>(_storage.data()) % 64) % 64 / sizeof(float));
+        }
+        compute_voxel_grid(const compute_voxel_grid&) = delete;
+        compute_voxel_grid(compute_voxel_grid&&) = default;
+        compute_voxel_grid& operator=(const compute_voxel_grid&) = delete;
+        compute_voxel_grid& operator=(compute_voxel_grid&&) = default;
+        virtual ~compute_voxel_grid() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            if (!_started) {
+                _started = true;
+                _begin_t = event.t;
+            } else if (event.t >= _begin_t + _duration) {
+                pass(_begin_t, _begin_t + _duration);
+                clear();
+                _begin_t = event.t;
+            }
+            accumulate(event, _begin_t, static_cast<float>(_bins - 1) / _duration, 0, _bins);
+        }
+
+        /// operator() builds the grid of a batch of events sorted by timestamp, and passes it.
+        /// The events accumulated by operator()(Event) since the last grid are discarded.
+        void operator()(const Event* begin, const Event* end) {
+            clear();
+            _started = false;
+            if (begin == end) {
+                return;
+            }
+            const auto begin_t = begin->t;
+            const auto end_t = (end - 1)->t;
+            const auto scale = end_t > begin_t ? static_cast<float>(_bins - 1) / (end_t - begin_t) : 0.0f;
+            const auto threads = std::min(_threads, static_cast<std::size_t>(_bins));
+            const auto build = [&](std::size_t index) {
+                const auto first_bin = static_cast<uint16_t>(_bins * index / threads);
+                const auto last_bin = static_cast<uint16_t>(_bins * (index + 1) / threads);
+                // an event contributes to the bins floor(position) and floor(position) + 1
+                const auto first_event = std::partition_point(begin, end, [&](const Event& event) {
+                    return lower_bin(event, begin_t, scale) + 1 < first_bin;
+                });
+                const auto last_event = std::partition_point(first_event, end, [&](const Event& event) {
+                    return lower_bin(event, begin_t, scale) < last_bin;
+                });
+                for (auto event = first_event; event != last_event; ++event) {
+                    accumulate(*event, begin_t, scale, first_bin, last_bin);
+                }
+            };
+            if (threads == 1) {
+                build(0);
+            } else {
+                std::vector<std::thread> workers;
+                for (std::size_t index = 1; index < threads; ++index) {
+                    workers.emplace_back(build, index);
+                }
+                build(0);
+                for (auto& worker : workers) {
+                    worker.join();
+                }
+            }
+            pass(begin_t, end_t);
+        }
+
+        protected:
+        /// values returns the first value of the grid.
+        float* values() {
+            return _storage.data() + _offset;
+        }
+
+        /// clear sets the grid's values to zero.
+        void clear() {
+            std::memset(values(), 0, _size * sizeof(float));
+        }
+
+        /// pass hands the grid to handle_voxel_grid.
+        void pass(uint64_t begin_t, uint64_t end_t) {
+            _handle_voxel_grid(voxel_grid_view{begin_t, end_t, _bins, _height, _width, values()});
+        }
+
+        /// lower_bin returns the earliest bin an event contributes to.
+        static uint16_t lower_bin(const Event& event, uint64_t begin_t, float scale) {
+            return static_cast<uint16_t>(static_cast<float>(event.t - begin_t) * scale);
+        }
+
+        /// accumulate adds an event's contributions to the bins in the range [first_bin, last_bin[.
+        void accumulate(const Event& event, uint64_t begin_t, float scale, uint16_t first_bin, uint16_t last_bin) {
+            const auto position = static_cast<float>(event.t - begin_t) * scale;
+            const auto bin = static_cast<uint16_t>(position);
+            const auto weight = position - bin;
+            const auto polarity = event.polarity ? 1.0f : -1.0f;
+            const auto pixel = static_cast<std::size_t>(event.x) + static_cast<std::size_t>(event.y) * _width;
+            const auto plane = static_cast<std::size_t>(_width) * _height;
+            auto grid = values();
+            if (bin >= first_bin && bin < last_bin) {
+                grid[bin * plane + pixel] += polarity * (1.0f - weight);
+            }
+            if (bin + 1 >= first_bin && bin + 1 < last_bin) {
+                grid[(bin + 1) * plane + pixel] += polarity * weight;
+            }
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint16_t _bins;
+        const uint64_t _duration;
+        const std::size_t _threads;
+        HandleVoxelGrid _handle_voxel_grid;
+        const std::size_t _size;
+        std::vector<float> _storage;
+        std::size_t _offset;
+        uint64_t _begin_t;
+        bool _started;
+    };
+
+    /// make_compute_voxel_grid creates a compute_voxel_grid from functors.
+    /// If threads is 0, the batch operator uses as many threads as the hardware supports.
+    template <typename Event, typename HandleVoxelGrid>
+    inline compute_voxel_grid<Event, HandleVoxelGrid> make_compute_voxel_grid(
+        uint16_t width,
+        uint16_t height,
+        uint16_t bins,
+        uint64_t duration,
+        std::size_t threads,
+        HandleVoxelGrid&& handle_voxel_grid) {
+        return compute_voxel_grid<Event, HandleVoxelGrid>(
+            width,
+            height,
+            bins,
+            duration,
+            threads,
+            std::forward<HandleVoxelGrid>(handle_voxel_grid));
+    }
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "state.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// fast_circle describes the Bresenham circle of the given radius, as used by detect_corners.
+    /// quarter_offsets lists the first quarter of the circle in order, starting at (0, radius). The other quarters
+    /// are rotations of the first one.
+    /// The arcs of a corner contain between minimum_arc and maximum_arc pixels.
+    template <uint16_t radius>
+    struct fast_circle;
+
+    template <>
+    struct fast_circle<3> {
+        static constexpr std::size_t quarter = 4;
+        static constexpr std::size_t minimum_arc = 3;
+        static constexpr std::size_t maximum_arc = 6;
+        static std::array<std::pair<int16_t, int16_t>, quarter> quarter_offsets() {
+            return {{{0, 3}, {1, 3}, {2, 2}, {3, 1}}};
+        }
+    };
+
+    template <>
+    struct fast_circle<4> {
+        static constexpr std::size_t quarter = 5;
+        static constexpr std::size_t minimum_arc = 4;
+        static constexpr std::size_t maximum_arc = 8;
+        static std::array<std::pair<int16_t, int16_t>, quarter> quarter_offsets() {
+            return {{{0, 4}, {1, 4}, {2, 3}, {3, 2}, {4, 1}}};
+        }
+    };
+
+    template <>
+    struct fast_circle<5> {
+        static constexpr std::size_t quarter = 7;
+        static constexpr std::size_t minimum_arc = 5;
+        static constexpr std::size_t maximum_arc = 11;
+        static std::array<std::pair<int16_t, int16_t>, quarter> quarter_offsets() {
+            return {{{0, 5}, {1, 5}, {2, 5}, {3, 4}, {4, 3}, {5, 2}, {5, 1}}};
+        }
+    };
+
+    /// detect_corners propagates only the events detected as corners by an arc test on the surface of active
+    /// events (eFAST, Mueggler et al., 2017).
+    /// The handler keeps the latest timestamp of each pixel and polarity. An event is a corner if, on both circles
+    /// centered on it, the most recent timestamps form a contiguous arc whose length is in the circle's range.
+    /// The circles' pixels are converted to index offsets on construction, and the test uses only the stack.
+    /// Events closer to the border than outer_radius are never corners.
+    template <typename Event, uint16_t inner_radius, uint16_t outer_radius, typename HandleEvent>
+    class detect_corners {
+        public:
+        /// inner_size is the number of pixels of the inner circle.
+        static constexpr std::size_t inner_size = fast_circle<inner_radius>::quarter * 4;
+
+        /// outer_size is the number of pixels of the outer circle.
+        static constexpr std::size_t outer_size = fast_circle<outer_radius>::quarter * 4;
+
+        static_assert(inner_radius < outer_radius, "inner_radius must be smaller than outer_radius");
+
+        detect_corners(uint16_t width, uint16_t height, HandleEvent&& handle_event) :
+            _width(width),
+            _height(height),
+            _handle_event(std::forward<HandleEvent>(handle_event)),
+            _inner_offsets(offsets<inner_radius>(width)),
+            _outer_offsets(offsets<outer_radius>(width)),
+            _ts(width * height * 2, 0) {}
+        detect_corners(const detect_corners&) = delete;
+        detect_corners(detect_corners&&) = default;
+        detect_corners& operator=(const detect_corners&) = delete;
+        detect_corners& operator=(detect_corners&&) = default;
+        virtual ~detect_corners() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto index = event.x + event.y * _width + (event.polarity ? _width * _height : 0);
+            _ts[index] = event.t;
+            if (event.x < outer_radius || event.x >= _width - outer_radius || event.y < outer_radius
+                || event.y >= _height - outer_radius) {
+                return;
+            }
+            if (is_corner<inner_size>(
+                    index,
+                    _inner_offsets,
+                    fast_circle<inner_radius>::minimum_arc,
+                    fast_circle<inner_radius>::maximum_arc)
+                && is_corner<outer_size>(
+                    index,
+                    _outer_offsets,
+                    fast_circle<outer_radius>::minimum_arc,
+                    fast_circle<outer_radius>::maximum_arc)) {
+                _handle_event(event);
+            }
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "detect_corners");
+            state_format::write_buffer(stream, _ts);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "detect_corners");
+            state_format::read_buffer(stream, _ts);
+        }
+
+        protected:
+        /// offsets converts a circle to index offsets, in order around the circle.
+        template <uint16_t radius>
+        static std::array<int32_t, fast_circle<radius>::quarter * 4> offsets(uint16_t width) {
+            std::array<int32_t, fast_circle<radius>::quarter * 4> result;
+            auto quarter_offsets = fast_circle<radius>::quarter_offsets();
+            for (std::size_t quarter = 0; quarter < 4; ++quarter) {
+                for (std::size_t index = 0; index < quarter_offsets.size(); ++index) {
+                    auto& offset = quarter_offsets[index];
+                    result[quarter * quarter_offsets.size() + index] = offset.first + offset.second * width;
+                    offset = {offset.second, static_cast<int16_t>(-offset.first)};
+                }
+            }
+            return result;
+        }
+
+        /// is_corner runs the arc test on a circle.
+        /// An arc is valid if its oldest timestamp is more recent than every timestamp outside of it.
+        template <std::size_t size>
+        bool is_corner(
+            std::size_t index,
+            const std::array<int32_t, size>& offsets,
+            std::size_t minimum_arc,
+            std::size_t maximum_arc) const {
+            std::array<uint64_t, size> ts;
+            for (std::size_t position = 0; position < size; ++position) {
+                ts[position] = _ts[index + offsets[position]];
+            }
+            for (std::size_t begin = 0; begin < size; ++begin) {
+                // an arc starts with a timestamp more recent than its predecessor's
+                if (ts[begin] < ts[(begin + size - 1) % size]) {
+                    continue;
+                }
+                auto oldest_t = ts[begin];
+                for (std::size_t length = 1; length <= maximum_arc; ++length) {
+                    if (length > 1) {
+                        oldest_t = std::min(oldest_t, ts[(begin + length - 1) % size]);
+                    }
+                    if (length < minimum_arc || ts[(begin + length - 1) % size] < ts[(begin + length) % size]) {
+                        continue;
+                    }
+                    auto valid = true;
+                    for (std::size_t position = length; position < size; ++position) {
+                        if (ts[(begin + position) % size] >= oldest_t) {
+                            valid = false;
+                            break;
+                        }
+                    }
+                    if (valid) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        HandleEvent _handle_event;
+        const std::array<int32_t, inner_size> _inner_offsets;
+        const std::array<int32_t, outer_size> _outer_offsets;
+        std::vector<uint64_t> _ts;
+    };
+
+    /// make_detect_corners creates a detect_corners from a functor.
+    template <typename Event, uint16_t inner_radius, uint16_t outer_radius, typename HandleEvent>
+    inline detect_corners<Event, inner_radius, outer_radius, HandleEvent>
+    make_detect_corners(uint16_t width, uint16_t height, HandleEvent&& handle_event) {
+        return detect_corners<Event, inner_radius, outer_radius, HandleEvent>(
+            width, height, std::forward<HandleEvent>(handle_event));
+    }
+}
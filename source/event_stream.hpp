@@ -0,0 +1,524 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// event_stream_format describes the binary layout of event stream files.
+    /// A file is made of a header, a list of blocks, a block index and a footer.
+    /// Each block starts with its first timestamp, its number of events and its
+    /// payload size. Each event is encoded as a variable-length timestamp delta
+    /// (7 bits per byte, little-endian) followed by x, y and polarity packed
+    /// into 4 bytes. Integers are stored in little-endian order.
+    namespace event_stream_format {
+        /// signature is the first and last 8 bytes of a file.
+        const std::array<uint8_t, 8> signature{{'T', 'A', 'R', 'S', 'I', 'E', 'R', 'E'}};
+
+        /// version is the format version.
+        const uint8_t version = 1;
+
+        /// header_size is the number of bytes of the file header.
+        const std::size_t header_size = 24;
+
+        /// block_header_size is the number of bytes before each block's payload.
+        const std::size_t block_header_size = 16;
+
+        /// index_entry_size is the number of bytes of each block index entry.
+        const std::size_t index_entry_size = 32;
+
+        /// footer_size is the number of bytes of the file footer.
+        const std::size_t footer_size = 32;
+
+        /// maximum_event_size is the maximum number of bytes of an encoded event.
+        const std::size_t maximum_event_size = 14;
+
+        /// bits returns the number of bits required to store the integers in the range [0, size[.
+        inline uint8_t bits(uint16_t size) {
+            uint8_t result = 0;
+            while (result < 16 && (static_cast<uint32_t>(1) << result) < size) {
+                ++result;
+            }
+            return result;
+        }
+
+        /// write_integer stores an integer in little-endian order.
+        template <typename Integer>
+        inline void write_integer(uint8_t* bytes, Integer value) {
+            for (std::size_t index = 0; index < sizeof(Integer); ++index) {
+                bytes[index] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * index));
+            }
+        }
+
+        /// read_integer loads an integer in little-endian order.
+        template <typename Integer>
+        inline Integer read_integer(const uint8_t* bytes) {
+            uint64_t value = 0;
+            for (std::size_t index = 0; index < sizeof(Integer); ++index) {
+                value |= static_cast<uint64_t>(bytes[index]) << (8 * index);
+            }
+            return static_cast<Integer>(value);
+        }
+
+        /// index_entry describes a block.
+        struct index_entry {
+            uint64_t first_t;
+            uint64_t last_t;
+            uint64_t offset;
+            uint64_t size;
+        };
+    }
+
+    /// write_stream encodes events with t, x, y and polarity fields into a file, block by block.
+    /// Events must be written in non-decreasing timestamp order. The block index
+    /// and the footer are written by the destructor.
+    template <typename Event>
+    class write_stream {
+        public:
+        write_stream(const std::string& filename, uint16_t width, uint16_t height, std::size_t block_size) :
+            _file(filename, std::ofstream::binary),
+            _width(width),
+            _height(height),
+            _x_bits(event_stream_format::bits(width)),
+            _y_bits(event_stream_format::bits(height)),
+            _block_size(block_size),
+            _offset(event_stream_format::header_size),
+            _block_count(0),
+            _first_t(0),
+            _previous_t(0),
+            _number_of_events(0) {
+            if (!_file.good()) {
+                throw std::runtime_error(std::string("the file '") + filename + "' could not be open for writing");
+            }
+            if (_x_bits + _y_bits + 1 > 32) {
+                throw std::logic_error("width and height are too large to be packed with the polarity into 32 bits");
+            }
+            if (_block_size == 0) {
+                throw std::logic_error("block_size must be larger than 0");
+            }
+            _block.reserve(
+                event_stream_format::block_header_size + _block_size * event_stream_format::maximum_event_size);
+            _block.resize(event_stream_format::block_header_size);
+            std::array<uint8_t, event_stream_format::header_size> header;
+            header.fill(0);
+            std::copy(event_stream_format::signature.begin(), event_stream_format::signature.end(), header.begin());
+            header[8] = event_stream_format::version;
+            header[9] = _x_bits;
+            header[10] = _y_bits;
+            event_stream_format::write_integer<uint16_t>(header.data() + 12, width);
+            event_stream_format::write_integer<uint16_t>(header.data() + 14, height);
+            event_stream_format::write_integer<uint64_t>(header.data() + 16, _block_size);
+            _file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        }
+        write_stream(const write_stream&) = delete;
+        write_stream(write_stream&&) = default;
+        write_stream& operator=(const write_stream&) = delete;
+        write_stream& operator=(write_stream&&) = default;
+        virtual ~write_stream() {
+            if (!_file.is_open()) {
+                return;
+            }
+            flush();
+            std::vector<uint8_t> index(_index.size() * event_stream_format::index_entry_size);
+            for (std::size_t block = 0; block < _index.size(); ++block) {
+                auto entry = index.data() + block * event_stream_format::index_entry_size;
+                event_stream_format::write_integer<uint64_t>(entry, _index[block].first_t);
+                event_stream_format::write_integer<uint64_t>(entry + 8, _index[block].last_t);
+                event_stream_format::write_integer<uint64_t>(entry + 16, _index[block].offset);
+                event_stream_format::write_integer<uint64_t>(entry + 24, _index[block].size);
+            }
+            _file.write(reinterpret_cast<const char*>(index.data()), index.size());
+            std::array<uint8_t, event_stream_format::footer_size> footer;
+            event_stream_format::write_integer<uint64_t>(footer.data(), _offset);
+            event_stream_format::write_integer<uint64_t>(footer.data() + 8, _index.size());
+            event_stream_format::write_integer<uint64_t>(footer.data() + 16, _number_of_events);
+            std::copy(
+                event_stream_format::signature.begin(), event_stream_format::signature.end(), footer.begin() + 24);
+            _file.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+        }
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            if (_number_of_events > 0 && event.t < _previous_t) {
+                throw std::runtime_error("events must be written in non-decreasing timestamp order");
+            }
+            // an out-of-range coordinate would spill into the other packed fields
+            if (event.x >= _width || event.y >= _height) {
+                throw std::logic_error("the event's coordinates must be smaller than width and height");
+            }
+            if (_block_count == 0) {
+                _first_t = event.t;
+                _previous_t = event.t;
+            }
+            auto delta_t = static_cast<uint64_t>(event.t - _previous_t);
+            _previous_t = event.t;
+            while (delta_t >= 0x80) {
+                _block.push_back(static_cast<uint8_t>(delta_t | 0x80));
+                delta_t >>= 7;
+            }
+            _block.push_back(static_cast<uint8_t>(delta_t));
+            const auto position = _block.size();
+            _block.resize(position + 4);
+            event_stream_format::write_integer<uint32_t>(
+                _block.data() + position,
+                static_cast<uint32_t>(event.x) | (static_cast<uint32_t>(event.y) << _x_bits)
+                    | (static_cast<uint32_t>(event.polarity ? 1 : 0) << (_x_bits + _y_bits)));
+            ++_block_count;
+            ++_number_of_events;
+            if (_block_count == _block_size) {
+                flush();
+            }
+        }
+
+        protected:
+        /// flush writes the current block to the file.
+        void flush() {
+            if (_block_count == 0) {
+                return;
+            }
+            event_stream_format::write_integer<uint64_t>(_block.data(), _first_t);
+            event_stream_format::write_integer<uint32_t>(_block.data() + 8, static_cast<uint32_t>(_block_count));
+            event_stream_format::write_integer<uint32_t>(
+                _block.data() + 12, static_cast<uint32_t>(_block.size() - event_stream_format::block_header_size));
+            _file.write(reinterpret_cast<const char*>(_block.data()), _block.size());
+            _index.push_back({_first_t, _previous_t, _offset, _block_count});
+            _offset += _block.size();
+            _block.resize(event_stream_format::block_header_size);
+            _block_count = 0;
+        }
+
+        std::ofstream _file;
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint8_t _x_bits;
+        const uint8_t _y_bits;
+        const std::size_t _block_size;
+        std::vector<uint8_t> _block;
+        std::vector<event_stream_format::index_entry> _index;
+        uint64_t _offset;
+        std::size_t _block_count;
+        uint64_t _first_t;
+        uint64_t _previous_t;
+        uint64_t _number_of_events;
+    };
+
+    /// make_write_stream creates a write_stream.
+    template <typename Event>
+    inline write_stream<Event>
+    make_write_stream(const std::string& filename, uint16_t width, uint16_t height, std::size_t block_size) {
+        return write_stream<Event>(filename, width, height, block_size);
+    }
+
+    /// memory_map maps a file in memory for reading.
+    class memory_map {
+        public:
+        memory_map(const std::string& filename) : _data(nullptr), _size(0) {
+#ifdef _WIN32
+            _file = CreateFileA(
+                filename.c_str(),
+                GENERIC_READ,
+                FILE_SHARE_READ,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_FLAG_SEQUENTIAL_SCAN,
+                nullptr);
+            if (_file == INVALID_HANDLE_VALUE) {
+                throw std::runtime_error(std::string("the file '") + filename + "' could not be open for reading");
+            }
+            LARGE_INTEGER size;
+            GetFileSizeEx(_file, &size);
+            _size = static_cast<std::size_t>(size.QuadPart);
+            _mapping = nullptr;
+            if (_size > 0) {
+                _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (_mapping == nullptr) {
+                    CloseHandle(_file);
+                    throw std::runtime_error(std::string("the file '") + filename + "' could not be mapped");
+                }
+                _data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+#else
+            _file = open(filename.c_str(), O_RDONLY);
+            if (_file < 0) {
+                throw std::runtime_error(std::string("the file '") + filename + "' could not be open for reading");
+            }
+            struct stat status;
+            if (fstat(_file, &status) != 0) {
+                close(_file);
+                throw std::runtime_error(std::string("the file '") + filename + "' could not be inspected");
+            }
+            _size = static_cast<std::size_t>(status.st_size);
+            if (_size > 0) {
+                auto data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+                if (data == MAP_FAILED) {
+                    close(_file);
+                    throw std::runtime_error(std::string("the file '") + filename + "' could not be mapped");
+                }
+                madvise(data, _size, MADV_SEQUENTIAL);
+                _data = static_cast<const uint8_t*>(data);
+            }
+#endif
+        }
+        memory_map(const memory_map&) = delete;
+        memory_map(memory_map&&) = delete;
+        memory_map& operator=(const memory_map&) = delete;
+        memory_map& operator=(memory_map&&) = delete;
+        virtual ~memory_map() {
+#ifdef _WIN32
+            if (_data != nullptr) {
+                UnmapViewOfFile(_data);
+            }
+            if (_mapping != nullptr) {
+                CloseHandle(_mapping);
+            }
+            CloseHandle(_file);
+#else
+            if (_data != nullptr) {
+                munmap(const_cast<uint8_t*>(_data), _size);
+            }
+            close(_file);
+#endif
+        }
+
+        /// data returns the first byte of the file.
+        const uint8_t* data() const {
+            return _data;
+        }
+
+        /// size returns the number of bytes of the file.
+        std::size_t size() const {
+            return _size;
+        }
+
+        protected:
+        const uint8_t* _data;
+        std::size_t _size;
+#ifdef _WIN32
+        HANDLE _file;
+        HANDLE _mapping;
+#else
+        int _file;
+#endif
+    };
+
+    /// read_stream decodes events from a memory-mapped file, block by block.
+    /// Event must be default-constructible, with t, x, y and polarity fields.
+    template <typename Event>
+    class read_stream {
+        public:
+        read_stream(const std::string& filename) :
+            _map(new memory_map(filename)),
+            _block(0),
+            _minimum_t(0) {
+            const auto data = _map->data();
+            const auto size = _map->size();
+            if (size < event_stream_format::header_size + event_stream_format::footer_size
+                || !std::equal(
+                    event_stream_format::signature.begin(), event_stream_format::signature.end(), data)
+                || !std::equal(
+                    event_stream_format::signature.begin(),
+                    event_stream_format::signature.end(),
+                    data + size - event_stream_format::signature.size())) {
+                throw std::runtime_error(std::string("the file '") + filename + "' is not an event stream");
+            }
+            if (data[8] != event_stream_format::version) {
+                throw std::runtime_error(std::string("the file '") + filename + "' has an unsupported version");
+            }
+            _x_bits = data[9];
+            _y_bits = data[10];
+            _width = event_stream_format::read_integer<uint16_t>(data + 12);
+            _height = event_stream_format::read_integer<uint16_t>(data + 14);
+            _block_size = event_stream_format::read_integer<uint64_t>(data + 16);
+            if (_x_bits + _y_bits + 1 > 32) {
+                throw std::runtime_error(std::string("the file '") + filename + "' has a corrupted header");
+            }
+            const auto footer = data + size - event_stream_format::footer_size;
+            const auto index_offset = event_stream_format::read_integer<uint64_t>(footer);
+            const auto number_of_blocks = event_stream_format::read_integer<uint64_t>(footer + 8);
+            _number_of_events = event_stream_format::read_integer<uint64_t>(footer + 16);
+            // the index must fill the bytes between the blocks and the footer, which is checked with a division
+            // since number_of_blocks * index_entry_size may overflow
+            if (index_offset < event_stream_format::header_size
+                || index_offset > size - event_stream_format::footer_size
+                || (size - event_stream_format::footer_size - index_offset) % event_stream_format::index_entry_size != 0
+                || (size - event_stream_format::footer_size - index_offset) / event_stream_format::index_entry_size
+                       != number_of_blocks) {
+                throw std::runtime_error(std::string("the file '") + filename + "' has a corrupted index");
+            }
+            _index.resize(number_of_blocks);
+            uint64_t maximum_count = 0;
+            for (std::size_t block = 0; block < number_of_blocks; ++block) {
+                const auto entry = data + index_offset + block * event_stream_format::index_entry_size;
+                _index[block].first_t = event_stream_format::read_integer<uint64_t>(entry);
+                _index[block].last_t = event_stream_format::read_integer<uint64_t>(entry + 8);
+                _index[block].offset = event_stream_format::read_integer<uint64_t>(entry + 16);
+                _index[block].size = event_stream_format::read_integer<uint64_t>(entry + 24);
+                // each block must lie between the header and the index, and hold its number of events
+                // (an event is encoded with at least 5 bytes)
+                const auto offset = _index[block].offset;
+                if (offset < event_stream_format::header_size || offset > index_offset
+                    || index_offset - offset < event_stream_format::block_header_size) {
+                    throw std::runtime_error(std::string("the file '") + filename + "' has a corrupted index");
+                }
+                const auto count = event_stream_format::read_integer<uint32_t>(data + offset + 8);
+                const auto payload_size = event_stream_format::read_integer<uint32_t>(data + offset + 12);
+                if (payload_size > index_offset - offset - event_stream_format::block_header_size
+                    || count != _index[block].size || count > _block_size
+                    || static_cast<uint64_t>(count) * 5 > payload_size) {
+                    throw std::runtime_error(std::string("the file '") + filename + "' has a corrupted block");
+                }
+                maximum_count = std::max(maximum_count, static_cast<uint64_t>(count));
+            }
+            // the events buffer is bounded by the file's content rather than the header's block size
+            _events.resize(static_cast<std::size_t>(maximum_count));
+        }
+        read_stream(const read_stream&) = delete;
+        read_stream(read_stream&&) = default;
+        read_stream& operator=(const read_stream&) = delete;
+        read_stream& operator=(read_stream&&) = default;
+        virtual ~read_stream() = default;
+
+        /// width returns the sensor width.
+        uint16_t width() const {
+            return _width;
+        }
+
+        /// height returns the sensor height.
+        uint16_t height() const {
+            return _height;
+        }
+
+        /// number_of_events returns the total number of events in the file.
+        uint64_t number_of_events() const {
+            return _number_of_events;
+        }
+
+        /// first_t returns the timestamp of the first event, or 0 if the file has no events.
+        uint64_t first_t() const {
+            return _index.empty() ? 0 : _index.front().first_t;
+        }
+
+        /// last_t returns the timestamp of the last event, or 0 if the file has no events.
+        uint64_t last_t() const {
+            return _index.empty() ? 0 : _index.back().last_t;
+        }
+
+        /// seek moves to the first event whose timestamp is larger than or equal to t.
+        void seek(uint64_t t) {
+            _block = static_cast<std::size_t>(
+                std::lower_bound(
+                    _index.begin(),
+                    _index.end(),
+                    t,
+                    [](const event_stream_format::index_entry& entry, uint64_t t) { return entry.last_t < t; })
+                - _index.begin());
+            _minimum_t = t;
+        }
+
+        /// read_block decodes the next block, and passes its events as a range of pointers.
+        /// It returns false if the end of the file was reached.
+        template <typename HandleBatch>
+        bool read_block(HandleBatch&& handle_batch) {
+            if (_block >= _index.size()) {
+                return false;
+            }
+            const auto& entry = _index[_block];
+            auto bytes = _map->data() + entry.offset;
+            auto t = event_stream_format::read_integer<uint64_t>(bytes);
+            const auto count = event_stream_format::read_integer<uint32_t>(bytes + 8);
+            const auto end = bytes + event_stream_format::block_header_size
+                             + event_stream_format::read_integer<uint32_t>(bytes + 12);
+            bytes += event_stream_format::block_header_size;
+            const uint32_t x_mask = (static_cast<uint32_t>(1) << _x_bits) - 1;
+            const uint32_t y_mask = (static_cast<uint32_t>(1) << _y_bits) - 1;
+            const auto polarity_shift = _x_bits + _y_bits;
+            auto event = _events.data();
+            for (uint32_t index = 0; index < count; ++index) {
+                if (bytes == end) {
+                    throw std::runtime_error("the block is corrupted");
+                }
+                uint64_t delta_t = *bytes & 0x7f;
+                for (uint8_t shift = 7; *bytes & 0x80; shift += 7) {
+                    ++bytes;
+                    if (bytes == end || shift > 63) {
+                        throw std::runtime_error("the block is corrupted");
+                    }
+                    delta_t |= static_cast<uint64_t>(*bytes & 0x7f) << shift;
+                }
+                ++bytes;
+                if (end - bytes < 4) {
+                    throw std::runtime_error("the block is corrupted");
+                }
+                t += delta_t;
+                const auto packed = event_stream_format::read_integer<uint32_t>(bytes);
+                bytes += 4;
+                event->t = t;
+                event->x = static_cast<uint16_t>(packed & x_mask);
+                event->y = static_cast<uint16_t>((packed >> _x_bits) & y_mask);
+                event->polarity = ((packed >> polarity_shift) & 1) == 1;
+                ++event;
+            }
+            ++_block;
+            auto begin = static_cast<const Event*>(_events.data());
+            if (_minimum_t > 0) {
+                begin = std::lower_bound(
+                    begin, static_cast<const Event*>(event), _minimum_t, [](const Event& event, uint64_t t) {
+                        return event.t < t;
+                    });
+                _minimum_t = 0;
+            }
+            handle_batch(begin, static_cast<const Event*>(event));
+            return true;
+        }
+
+        /// read decodes the remaining events, and passes them one by one.
+        template <typename HandleEvent>
+        void read(HandleEvent&& handle_event) {
+            while (read_block([&](const Event* begin, const Event* end) {
+                for (; begin != end; ++begin) {
+                    handle_event(*begin);
+                }
+            })) {
+            }
+        }
+
+        protected:
+        std::unique_ptr<memory_map> _map;
+        uint8_t _x_bits;
+        uint8_t _y_bits;
+        uint16_t _width;
+        uint16_t _height;
+        uint64_t _block_size;
+        uint64_t _number_of_events;
+        std::vector<event_stream_format::index_entry> _index;
+        std::vector<Event> _events;
+        std::size_t _block;
+        uint64_t _minimum_t;
+    };
+
+    /// make_read_stream creates a read_stream.
+    template <typename Event>
+    inline read_stream<Event> make_read_stream(const std::string& filename) {
+        return read_stream<Event>(filename);
+    }
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "pipeline.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// probe_snapshot is a copy of a probe's counters and latency histogram.
+    /// The histogram is log-linear: each power of two is split into 8 linear buckets.
+    struct probe_snapshot {
+        /// buckets is the number of histogram buckets.
+        static const std::size_t buckets = 512;
+
+        /// events_in is the number of events received by the stage.
+        uint64_t events_in;
+
+        /// events_out is the number of events emitted by the stage.
+        uint64_t events_out;
+
+        /// histogram counts the sampled per-event latencies, in nanoseconds.
+        std::array<uint64_t, buckets> histogram;
+
+        /// bucket returns the histogram bucket of a latency in nanoseconds.
+        static std::size_t bucket(uint64_t latency) {
+            if (latency < 8) {
+                return static_cast<std::size_t>(latency);
+            }
+#ifdef _MSC_VER
+            unsigned long exponent;
+            _BitScanReverse64(&exponent, latency);
+#else
+            const auto exponent = 63 - __builtin_clzll(latency);
+#endif
+            return static_cast<std::size_t>((exponent - 2) * 8 + ((latency >> (exponent - 3)) & 7));
+        }
+
+        /// lower_bound returns the smallest latency in nanoseconds that belongs to the given bucket.
+        static uint64_t lower_bound(std::size_t bucket) {
+            if (bucket < 8) {
+                return bucket;
+            }
+            const auto exponent = bucket / 8 + 2;
+            return (static_cast<uint64_t>(8 + bucket % 8)) << (exponent - 3);
+        }
+
+        /// samples returns the number of sampled latencies.
+        uint64_t samples() const {
+            uint64_t result = 0;
+            for (auto count : histogram) {
+                result += count;
+            }
+            return result;
+        }
+
+        /// quantile returns the lower bound, in nanoseconds, of the bucket that contains the given quantile.
+        uint64_t quantile(double ratio) const {
+            const auto target = static_cast<uint64_t>(ratio * samples());
+            uint64_t cumulative = 0;
+            for (std::size_t index = 0; index < buckets; ++index) {
+                cumulative += histogram[index];
+                if (cumulative > target) {
+                    return lower_bound(index);
+                }
+            }
+            return 0;
+        }
+    };
+
+    /// basic_probe stores lock-free counters and a latency histogram for one stage.
+    /// It is written by the thread that handles events, and can be read by any thread with snapshot.
+    template <bool enabled>
+    class basic_probe {
+        public:
+        basic_probe(uint64_t sampling_period = 64) :
+            _sampling_mask(sampling_period - 1),
+            _events_in(0),
+            _events_out(0),
+            _is_sampling(false),
+            _downstream_duration(0) {
+            if (sampling_period == 0 || (sampling_period & (sampling_period - 1)) != 0) {
+                throw std::logic_error("sampling_period must be a power of two");
+            }
+            for (auto& count : _histogram) {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+        basic_probe(const basic_probe&) = delete;
+        basic_probe(basic_probe&&) = delete;
+        basic_probe& operator=(const basic_probe&) = delete;
+        basic_probe& operator=(basic_probe&&) = delete;
+        virtual ~basic_probe() = default;
+
+        /// snapshot copies the counters and the histogram.
+        probe_snapshot snapshot() const {
+            probe_snapshot result;
+            result.events_in = _events_in.load(std::memory_order_relaxed);
+            result.events_out = _events_out.load(std::memory_order_relaxed);
+            for (std::size_t index = 0; index < probe_snapshot::buckets; ++index) {
+                result.histogram[index] = _histogram[index].load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        /// input wraps the stage's handling of one event.
+        template <typename Handle>
+        void input(Handle&& handle) {
+            const auto events_in = _events_in.load(std::memory_order_relaxed);
+            _events_in.store(events_in + 1, std::memory_order_relaxed);
+            if ((events_in & _sampling_mask) != 0) {
+                handle();
+                return;
+            }
+            _is_sampling = true;
+            _downstream_duration = std::chrono::steady_clock::duration(0);
+            const auto begin = std::chrono::steady_clock::now();
+            handle();
+            const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - begin - _downstream_duration)
+                                     .count();
+            _is_sampling = false;
+            auto& count = _histogram[probe_snapshot::bucket(latency < 0 ? 0 : static_cast<uint64_t>(latency))];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /// output wraps the stage's emission of one event.
+        /// The time spent downstream is excluded from the stage's latency.
+        template <typename Handle>
+        void output(Handle&& handle) {
+            _events_out.store(_events_out.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (!_is_sampling) {
+                handle();
+                return;
+            }
+            const auto begin = std::chrono::steady_clock::now();
+            handle();
+            _downstream_duration += std::chrono::steady_clock::now() - begin;
+        }
+
+        protected:
+        const uint64_t _sampling_mask;
+        std::atomic<uint64_t> _events_in;
+        std::atomic<uint64_t> _events_out;
+        std::array<std::atomic<uint64_t>, probe_snapshot::buckets> _histogram;
+        bool _is_sampling;
+        std::chrono::steady_clock::duration _downstream_duration;
+    };
+
+    /// basic_probe<false> is an empty probe: every operation compiles to nothing.
+    template <>
+    class basic_probe<false> {
+        public:
+        basic_probe(uint64_t sampling_period = 64) {
+            if (sampling_period == 0 || (sampling_period & (sampling_period - 1)) != 0) {
+                throw std::logic_error("sampling_period must be a power of two");
+            }
+        }
+        basic_probe(const basic_probe&) = delete;
+        basic_probe(basic_probe&&) = delete;
+        basic_probe& operator=(const basic_probe&) = delete;
+        basic_probe& operator=(basic_probe&&) = delete;
+        ~basic_probe() = default;
+
+        /// snapshot returns zeroed counters and an empty histogram.
+        probe_snapshot snapshot() const {
+            probe_snapshot result;
+            result.events_in = 0;
+            result.events_out = 0;
+            result.histogram.fill(0);
+            return result;
+        }
+
+        /// input calls the stage's handling of one event.
+        template <typename Handle>
+        void input(Handle&& handle) {
+            handle();
+        }
+
+        /// output calls the stage's emission of one event.
+        template <typename Handle>
+        void output(Handle&& handle) {
+            handle();
+        }
+    };
+
+    /// probe is enabled only if TARSIER_INSTRUMENTATION is defined.
+#ifdef TARSIER_INSTRUMENTATION
+    typedef basic_probe<true> probe;
+#else
+    typedef basic_probe<false> probe;
+#endif
+
+    /// probe_input counts the events entering a stage, and samples the stage's latency.
+    template <typename Event, typename Probe, typename HandleEvent>
+    class probe_input {
+        public:
+        probe_input(Probe& probe, HandleEvent&& handle_event) :
+            _probe(probe),
+            _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        probe_input(const probe_input&) = delete;
+        probe_input(probe_input&&) = default;
+        probe_input& operator=(const probe_input&) = delete;
+        probe_input& operator=(probe_input&&) = delete;
+        virtual ~probe_input() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            _probe.input([&]() { _handle_event(event); });
+        }
+
+        protected:
+        Probe& _probe;
+        HandleEvent _handle_event;
+    };
+
+    /// make_probe_input creates a probe_input from a functor.
+    template <typename Event, typename Probe, typename HandleEvent>
+    inline probe_input<Event, Probe, HandleEvent> make_probe_input(Probe& probe, HandleEvent&& handle_event) {
+        return probe_input<Event, Probe, HandleEvent>(probe, std::forward<HandleEvent>(handle_event));
+    }
+
+    /// probe_output counts the events leaving a stage.
+    /// Since its Event type is only known when the stage calls it, operator() is a template.
+    template <typename Probe, typename HandleEvent>
+    class probe_output {
+        public:
+        probe_output(Probe& probe, HandleEvent&& handle_event) :
+            _probe(probe),
+            _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        probe_output(const probe_output&) = delete;
+        probe_output(probe_output&&) = default;
+        probe_output& operator=(const probe_output&) = delete;
+        probe_output& operator=(probe_output&&) = delete;
+        virtual ~probe_output() = default;
+
+        /// operator() handles an event.
+        template <typename Event>
+        void operator()(Event event) {
+            _probe.output([&]() { _handle_event(event); });
+        }
+
+        protected:
+        Probe& _probe;
+        HandleEvent _handle_event;
+    };
+
+    /// make_probe_output creates a probe_output from a functor.
+    template <typename Probe, typename HandleEvent>
+    inline probe_output<Probe, HandleEvent> make_probe_output(Probe& probe, HandleEvent&& handle_event) {
+        return probe_output<Probe, HandleEvent>(probe, std::forward<HandleEvent>(handle_event));
+    }
+
+    /// instrumented_stage decorates a pipeline stage with a probe_input and a probe_output.
+    template <typename Probe, typename Stage>
+    class instrumented_stage : public stage_base {
+        public:
+        instrumented_stage(Probe& probe, Stage&& stage) : _probe(probe), _stage(std::forward<Stage>(stage)) {}
+        instrumented_stage(const instrumented_stage&) = delete;
+        instrumented_stage(instrumented_stage&&) = default;
+        instrumented_stage& operator=(const instrumented_stage&) = delete;
+        instrumented_stage& operator=(instrumented_stage&&) = delete;
+        ~instrumented_stage() = default;
+
+        /// event_type is the type of the events handled by the stage.
+        typedef typename Stage::event_type event_type;
+
+        /// bind creates the instrumented handler, consuming the stored stage.
+        template <typename HandleEvent>
+        probe_input<
+            event_type,
+            Probe,
+            decltype(std::declval<Stage>().bind(std::declval<probe_output<Probe, HandleEvent>>()))>
+        bind(HandleEvent&& handle_event) && {
+            return make_probe_input<event_type>(
+                _probe, std::move(_stage).bind(make_probe_output(_probe, std::forward<HandleEvent>(handle_event))));
+        }
+
+        protected:
+        Probe& _probe;
+        Stage _stage;
+    };
+
+    /// instrument decorates a pipeline stage with a probe.
+    template <typename Probe, typename Stage>
+    inline instrumented_stage<Probe, typename std::decay<Stage>::type> instrument(Probe& probe, Stage&& stage) {
+        return instrumented_stage<Probe, typename std::decay<Stage>::type>(probe, std::forward<Stage>(stage));
+    }
+}
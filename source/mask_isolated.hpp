@@ -1,5 +1,6 @@
 #pragma once
 
+#include "state.hpp"
 #include <cstdint>
 #include <utility>
 #include <vector>
@@ -35,6 +36,19 @@ namespace tarsier {
             }
         }
 
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "mask_isolated");
+            state_format::write_buffer(stream, _ts);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "mask_isolated");
+            state_format::read_buffer(stream, _ts);
+        }
+
         protected:
         const uint16_t _width;
         const uint16_t _height;
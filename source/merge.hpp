@@ -3,16 +3,111 @@
 #include <array>
 #include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <future>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <thread>
 #include <vector>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
+
+    /// overflow lists the behaviours of merge when a source's fifo is full.
+    enum class overflow {
+        /// reject returns false, and leaves the event to the caller.
+        reject,
+
+        /// block waits until the fifo has room for the event, or until the timeout expires.
+        /// The event is dropped if the timeout expires.
+        block,
+
+        /// drop_newest discards the pushed event.
+        drop_newest,
+
+        /// drop_oldest discards the oldest event of the fifo to make room for the pushed event.
+        drop_oldest,
+
+        /// spill moves the event to a mutex-protected buffer, dispatched after the fifo's events.
+        /// The event is dropped if the spill buffer is full.
+        spill,
+    };
+
+    /// overflow_policy configures the overflow behaviour of a merge source.
+    /// timeout is only used by overflow::block, and spill_size by overflow::spill.
+    struct overflow_policy {
+        overflow strategy;
+        std::chrono::high_resolution_clock::duration timeout;
+        std::size_t spill_size;
+    };
+
+    /// merge_counters is a copy of a merge source's counters.
+    struct merge_counters {
+        /// pushes is the number of events accepted by the fifo or the spill buffer.
+        /// Events evicted by overflow::drop_oldest are counted both as pushes and as drops.
+        uint64_t pushes;
+
+        /// drops is the number of events discarded by the overflow policy.
+        uint64_t drops;
+
+        /// rejections is the number of events returned to the caller by overflow::reject.
+        uint64_t rejections;
+
+        /// high_water_mark is the largest number of events observed in the fifo by the dispatch thread.
+        std::size_t high_water_mark;
+
+        /// spill_high_water_mark is the largest number of events in the spill buffer.
+        std::size_t spill_high_water_mark;
+    };
+
+    /// dispatch_placement configures the scheduling of a merge's dispatch thread, and the placement of its fifos.
+    /// These options are only applied on Linux.
+    struct dispatch_placement {
+        /// cpu is the core the dispatch thread is pinned to, or -1 to let the scheduler choose.
+        int32_t cpu;
+
+        /// priority is the real-time (SCHED_FIFO) priority of the dispatch thread in the range [1, 99],
+        /// or 0 to keep the default scheduling. It usually requires the CAP_SYS_NICE capability.
+        int32_t priority;
+
+        /// first_touch allocates and initializes the fifos on the dispatch thread, after it is pinned,
+        /// so that the kernel maps their pages on the dispatch thread's NUMA node.
+        bool first_touch;
+    };
+
+    /// placement_report describes where a merge's dispatch thread and fifos ended up.
+    /// CPUs and nodes are -1 when they cannot be retrieved, for instance on platforms other than Linux.
+    struct placement_report {
+        /// affinity_applied is true if the dispatch thread was pinned to the requested cpu.
+        bool affinity_applied;
+
+        /// priority_applied is true if the dispatch thread was given the requested real-time priority.
+        bool priority_applied;
+
+        /// cpu is the core the dispatch thread was running on after its placement.
+        int32_t cpu;
+
+        /// node is the NUMA node of cpu.
+        int32_t node;
+
+        /// fifo_nodes contains the NUMA node of the first page of each source's fifo.
+        std::vector<int32_t> fifo_nodes;
+    };
+
     /// merge creates a unique event stream from sources running on different
-    /// threads.
+    /// threads. The events are buffered in a lock-free ring per source.
+    /// Each source has an overflow policy, applied when its fifo is full, and counters that can be read from any
+    /// thread.
+    /// The constructor returns once the dispatch thread is placed and the fifos are allocated.
     template <std::size_t sources, typename Event, typename HandleEvent>
     class merge {
         public:
@@ -20,49 +115,95 @@ namespace tarsier {
             std::size_t fifo_size,
             std::chrono::high_resolution_clock::duration sleep_duration,
             HandleEvent&& handle_event) :
+            merge(fifo_size, sleep_duration, reject_policies(), std::forward<HandleEvent>(handle_event)) {}
+        merge(
+            std::size_t fifo_size,
+            std::chrono::high_resolution_clock::duration sleep_duration,
+            const std::array<overflow_policy, sources>& policies,
+            HandleEvent&& handle_event) :
+            merge(
+                fifo_size,
+                sleep_duration,
+                policies,
+                dispatch_placement{-1, 0, false},
+                std::forward<HandleEvent>(handle_event)) {}
+        merge(
+            std::size_t fifo_size,
+            std::chrono::high_resolution_clock::duration sleep_duration,
+            const std::array<overflow_policy, sources>& policies,
+            dispatch_placement placement,
+            HandleEvent&& handle_event) :
             _fifo_size(fifo_size),
             _sleep_duration(sleep_duration),
+            _policies(policies),
+            _placement(placement),
             _handle_event(std::forward<HandleEvent>(handle_event)),
             _running(true) {
-            for (auto& fifo : _fifos) {
-                fifo.events.resize(_fifo_size);
-                fifo.head.store(0, std::memory_order_release);
-                fifo.tail.store(0, std::memory_order_release);
-            }
-            _loop = std::thread([this]() {
-                while (_running.load(std::memory_order_acquire)) {
-                    auto minimum_t = std::numeric_limits<uint64_t>::max();
-                    std::size_t minimum_source = 0;
-                    auto dispatch = true;
-                    for (std::size_t source = 0; source < sources; ++source) {
-                        if (_next_events_and_exists[source].second) {
-                            if (dispatch && _next_events_and_exists[source].first.t < minimum_t) {
-                                minimum_t = _next_events_and_exists[source].first.t;
-                                minimum_source = source;
-                            }
-                        } else {
-                            const auto current_head = _fifos[source].head.load(std::memory_order_relaxed);
-                            if (current_head == _fifos[source].tail.load(std::memory_order_acquire)) {
-                                dispatch = false;
-                            } else {
-                                _next_events_and_exists[source].first = _fifos[source].events[current_head];
-                                _fifos[source].head.store((current_head + 1) % _fifo_size, std::memory_order_release);
-                                _next_events_and_exists[source].second = true;
+            if (_fifo_size < 2) {
+                throw std::logic_error("fifo_size must be larger than 1");
+            }
+            for (const auto& policy : _policies) {
+                if (policy.strategy == overflow::spill && policy.spill_size == 0) {
+                    throw std::logic_error("spill_size must be larger than 0");
+                }
+            }
+            if (_placement.cpu < -1) {
+                throw std::logic_error("cpu must be -1 or a core index");
+            }
+            if (_placement.priority < 0 || _placement.priority > 99) {
+                throw std::logic_error("priority must be in the integer range [0, 99]");
+            }
+            if (!_placement.first_touch) {
+                allocate_fifos();
+            }
+            std::promise<void> placed;
+            auto placed_future = placed.get_future();
+            _loop = std::thread(
+                [this](std::promise<void> placed) {
+                    try {
+                        place();
+                        placed.set_value();
+                    } catch (...) {
+                        placed.set_exception(std::current_exception());
+                        return;
+                    }
+                    while (_running.load(std::memory_order_acquire)) {
+                        auto minimum_t = std::numeric_limits<uint64_t>::max();
+                        std::size_t minimum_source = 0;
+                        auto dispatch = true;
+                        for (std::size_t source = 0; source < sources; ++source) {
+                            if (_next_events_and_exists[source].second) {
                                 if (dispatch && _next_events_and_exists[source].first.t < minimum_t) {
                                     minimum_t = _next_events_and_exists[source].first.t;
                                     minimum_source = source;
                                 }
+                            } else {
+                                if (!pop(source, _next_events_and_exists[source].first)) {
+                                    dispatch = false;
+                                } else {
+                                    _next_events_and_exists[source].second = true;
+                                    if (dispatch && _next_events_and_exists[source].first.t < minimum_t) {
+                                        minimum_t = _next_events_and_exists[source].first.t;
+                                        minimum_source = source;
+                                    }
+                                }
                             }
                         }
+                        if (dispatch) {
+                            _handle_event(_next_events_and_exists[minimum_source].first);
+                            _next_events_and_exists[minimum_source].second = false;
+                        } else {
+                            std::this_thread::sleep_for(_sleep_duration);
+                        }
                     }
-                    if (dispatch) {
-                        _handle_event(_next_events_and_exists[minimum_source].first);
-                        _next_events_and_exists[minimum_source].second = false;
-                    } else {
-                        std::this_thread::sleep_for(_sleep_duration);
-                    }
-                }
-            });
+                },
+                std::move(placed));
+            try {
+                placed_future.get();
+            } catch (...) {
+                _loop.join();
+                throw;
+            }
         }
         merge(const merge&) = delete;
         merge(merge&&) = default;
@@ -82,12 +223,9 @@ namespace tarsier {
                             minimum_t = _next_events_and_exists[source].first.t;
                             minimum_source = source;
                         } else {
-                            const auto current_head = _fifos[source].head.load(std::memory_order_relaxed);
-                            if (current_head == _fifos[source].tail.load(std::memory_order_acquire)) {
+                            if (!pop(source, _next_events_and_exists[source].first)) {
                                 has_events[source] = false;
                             } else {
-                                _next_events_and_exists[source].first = _fifos[source].events[current_head];
-                                _fifos[source].head.store((current_head + 1) % _fifo_size, std::memory_order_release);
                                 _next_events_and_exists[source].second = true;
                                 if (_next_events_and_exists[source].first.t < minimum_t) {
                                     minimum_t = _next_events_and_exists[source].first.t;
@@ -106,33 +244,326 @@ namespace tarsier {
             }
         }
 
-        /// push handles an event from a specified source.
+        /// push handles an event from a specified source, and returns false if the event was not inserted.
+        /// Each source must be pushed to by a single thread, and its events must be sorted by timestamp.
         template <std::size_t source>
         bool push(Event event) {
             static_assert(source < sources, "source must be in the integer range [0, sources[");
             return push(source, event);
         }
         bool push(std::size_t source, Event event) {
-            const auto current_tail = _fifos[source].tail.load(std::memory_order_relaxed);
-            const auto next_tail = (current_tail + 1) % _fifo_size;
-            if (next_tail == _fifos[source].head.load(std::memory_order_acquire)) {
-                return false;
-            }
-            _fifos[source].events[current_tail] = event;
-            _fifos[source].tail.store(next_tail, std::memory_order_release);
-            return true;
+            return try_push(source, event) || push_overflow(source, event, false);
+        }
+
+        /// push_concurrent handles an event from a source shared by several threads, without locks.
+        /// All the threads pushing to the source must use push_concurrent.
+        /// Events are dispatched in the order in which their pushes reserved a slot, hence the source's events
+        /// are sorted by timestamp only if the producers coordinate, for instance if every push starts
+        /// after the completion of the pushes with smaller timestamps.
+        template <std::size_t source>
+        bool push_concurrent(Event event) {
+            static_assert(source < sources, "source must be in the integer range [0, sources[");
+            return push_concurrent(source, event);
+        }
+        bool push_concurrent(std::size_t source, Event event) {
+            return try_push_concurrent(source, event) || push_overflow(source, event, true);
+        }
+
+        /// counters returns a copy of a source's counters, and can be called from any thread.
+        merge_counters counters(std::size_t source) const {
+            const auto& fifo = _fifos[source];
+            merge_counters result;
+            result.pushes = fifo.tail.load(std::memory_order_relaxed)
+                            + fifo.spill_pushes.load(std::memory_order_relaxed);
+            result.drops = fifo.drops.load(std::memory_order_relaxed);
+            result.rejections = fifo.rejections.load(std::memory_order_relaxed);
+            result.high_water_mark = fifo.high_water_mark.load(std::memory_order_relaxed);
+            result.spill_high_water_mark = fifo.spill_high_water_mark.load(std::memory_order_relaxed);
+            return result;
+        }
+
+        /// placement returns the dispatch thread's cpu and node, and the fifos' nodes, retrieved after placement.
+        placement_report placement() const {
+            return _report;
         }
 
         protected:
+        /// slot stores an event and its sequence number.
+        /// The sequence is equal to the slot's write position when the slot is free,
+        /// and to the write position plus one when it contains an event.
+        struct slot {
+            std::atomic<std::size_t> sequence;
+            Event event;
+        };
+
         /// fifo stores the variables of a thread-safe fifo.
+        /// head and tail count the events popped and pushed since the creation of the fifo.
+        /// The variables written by the dispatch thread and by the producers are kept on different cache lines.
         struct fifo {
-            std::vector<Event> events;
+            std::unique_ptr<slot[]> slots;
             std::atomic<std::size_t> head;
+            std::atomic<std::size_t> high_water_mark;
+            uint8_t padding_0[64];
             std::atomic<std::size_t> tail;
+            std::atomic<uint64_t> drops;
+            std::atomic<uint64_t> rejections;
+            uint8_t padding_1[64];
+            std::atomic<std::size_t> spilled;
+            std::mutex spill_mutex;
+            std::deque<Event> spill;
+            std::atomic<uint64_t> spill_pushes;
+            std::atomic<std::size_t> spill_high_water_mark;
         };
 
+        /// allocate_fifos allocates and initializes the fifos.
+        /// The initialization writes every slot, hence it determines the pages' NUMA node under first-touch policy.
+        void allocate_fifos() {
+            for (auto& fifo : _fifos) {
+                fifo.slots.reset(new slot[_fifo_size]);
+                for (std::size_t index = 0; index < _fifo_size; ++index) {
+                    fifo.slots[index].sequence.store(index, std::memory_order_relaxed);
+                }
+                fifo.head.store(0, std::memory_order_relaxed);
+                fifo.high_water_mark.store(0, std::memory_order_relaxed);
+                fifo.tail.store(0, std::memory_order_relaxed);
+                fifo.drops.store(0, std::memory_order_relaxed);
+                fifo.rejections.store(0, std::memory_order_relaxed);
+                fifo.spilled.store(0, std::memory_order_relaxed);
+                fifo.spill_pushes.store(0, std::memory_order_relaxed);
+                fifo.spill_high_water_mark.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        /// place applies the dispatch placement from the dispatch thread, and fills the report.
+        void place() {
+            _report.affinity_applied = false;
+            _report.priority_applied = false;
+            _report.cpu = -1;
+            _report.node = -1;
+#ifdef __linux__
+            if (_placement.cpu >= 0 && _placement.cpu < CPU_SETSIZE) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(_placement.cpu, &cpus);
+                _report.affinity_applied = sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0;
+            }
+            if (_placement.priority > 0) {
+                sched_param parameters;
+                parameters.sched_priority = _placement.priority;
+                _report.priority_applied = sched_setscheduler(0, SCHED_FIFO, &parameters) == 0;
+            }
+#ifdef SYS_getcpu
+            unsigned int cpu;
+            unsigned int node;
+            if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+                _report.cpu = static_cast<int32_t>(cpu);
+                _report.node = static_cast<int32_t>(node);
+            }
+#endif
+#endif
+            if (_placement.first_touch) {
+                allocate_fifos();
+            }
+            _report.fifo_nodes.clear();
+            for (const auto& fifo : _fifos) {
+                _report.fifo_nodes.push_back(node_of(fifo.slots.get()));
+            }
+        }
+
+        /// node_of returns the NUMA node of the page that contains the given address, or -1.
+        static int32_t node_of(const void* address) {
+#if defined(__linux__) && defined(SYS_move_pages)
+            const auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+            void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) & ~(page_size - 1));
+            int status = -1;
+            // move_pages with null nodes only queries the pages' nodes
+            if (syscall(SYS_move_pages, 0, 1ul, &page, nullptr, &status, 0) == 0 && status >= 0) {
+                return static_cast<int32_t>(status);
+            }
+#else
+            static_cast<void>(address);
+#endif
+            return -1;
+        }
+
+        /// reject_policies returns the default policies, which reject events when a fifo is full.
+        static std::array<overflow_policy, sources> reject_policies() {
+            std::array<overflow_policy, sources> policies;
+            policies.fill(overflow_policy{overflow::reject, std::chrono::high_resolution_clock::duration(0), 0});
+            return policies;
+        }
+
+        /// try_push inserts an event in a source's fifo, if it has room and if its spill buffer is empty.
+        bool try_push(std::size_t source, Event event) {
+            auto& fifo = _fifos[source];
+            if (_policies[source].strategy == overflow::spill && fifo.spilled.load(std::memory_order_acquire) > 0) {
+                return false;
+            }
+            const auto position = fifo.tail.load(std::memory_order_relaxed);
+            auto& slot = fifo.slots[position % _fifo_size];
+            if (slot.sequence.load(std::memory_order_acquire) != position) {
+                return false;
+            }
+            slot.event = event;
+            fifo.tail.store(position + 1, std::memory_order_relaxed);
+            slot.sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// try_push_concurrent is the multi-producer version of try_push.
+        bool try_push_concurrent(std::size_t source, Event event) {
+            auto& fifo = _fifos[source];
+            if (_policies[source].strategy == overflow::spill && fifo.spilled.load(std::memory_order_acquire) > 0) {
+                return false;
+            }
+            auto position = fifo.tail.load(std::memory_order_relaxed);
+            for (;;) {
+                auto& slot = fifo.slots[position % _fifo_size];
+                const auto sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence == position) {
+                    if (fifo.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        slot.event = event;
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sequence < position) {
+                    return false;
+                } else {
+                    position = fifo.tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// push_overflow applies a source's overflow policy to an event that try_push could not insert.
+        bool push_overflow(std::size_t source, Event event, bool concurrent) {
+            auto& fifo = _fifos[source];
+            const auto& policy = _policies[source];
+            switch (policy.strategy) {
+                case overflow::reject:
+                    fifo.rejections.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                case overflow::block: {
+                    const auto deadline = std::chrono::high_resolution_clock::now() + policy.timeout;
+                    do {
+                        std::this_thread::yield();
+                        if (concurrent ? try_push_concurrent(source, event) : try_push(source, event)) {
+                            return true;
+                        }
+                    } while (std::chrono::high_resolution_clock::now() < deadline);
+                    break;
+                }
+                case overflow::drop_newest:
+                    break;
+                case overflow::drop_oldest: {
+                    Event oldest;
+                    std::size_t position;
+                    do {
+                        if (pop_ring_concurrent(fifo, oldest, position)) {
+                            fifo.drops.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    } while (!(concurrent ? try_push_concurrent(source, event) : try_push(source, event)));
+                    return true;
+                }
+                case overflow::spill: {
+                    std::lock_guard<std::mutex> lock(fifo.spill_mutex);
+                    if (fifo.spill.size() < policy.spill_size) {
+                        fifo.spill.push_back(event);
+                        fifo.spilled.store(fifo.spill.size(), std::memory_order_release);
+                        fifo.spill_pushes.fetch_add(1, std::memory_order_relaxed);
+                        if (fifo.spill.size() > fifo.spill_high_water_mark.load(std::memory_order_relaxed)) {
+                            fifo.spill_high_water_mark.store(fifo.spill.size(), std::memory_order_relaxed);
+                        }
+                        return true;
+                    }
+                    break;
+                }
+            }
+            fifo.drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        /// pop_ring retrieves the oldest event of a fifo that only the dispatch thread pops from.
+        bool pop_ring(fifo& fifo, Event& event) {
+            const auto position = fifo.head.load(std::memory_order_relaxed);
+            auto& slot = fifo.slots[position % _fifo_size];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                return false;
+            }
+            event = slot.event;
+            fifo.head.store(position + 1, std::memory_order_relaxed);
+            slot.sequence.store(position + _fifo_size, std::memory_order_release);
+            update_high_water_mark(fifo, position);
+            return true;
+        }
+
+        /// pop_ring_concurrent retrieves the oldest event of a fifo that producers may also pop from,
+        /// and its position.
+        bool pop_ring_concurrent(fifo& fifo, Event& event, std::size_t& position) {
+            position = fifo.head.load(std::memory_order_relaxed);
+            for (;;) {
+                auto& slot = fifo.slots[position % _fifo_size];
+                const auto sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence == position + 1) {
+                    if (fifo.head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        event = slot.event;
+                        slot.sequence.store(position + _fifo_size, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sequence < position + 1) {
+                    return false;
+                } else {
+                    position = fifo.head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// update_high_water_mark records the fifo's occupancy when the dispatch thread pops an event.
+        void update_high_water_mark(fifo& fifo, std::size_t position) {
+            const auto occupancy = fifo.tail.load(std::memory_order_relaxed) - position;
+            if (occupancy > fifo.high_water_mark.load(std::memory_order_relaxed)) {
+                fifo.high_water_mark.store(occupancy, std::memory_order_relaxed);
+            }
+        }
+
+        /// pop retrieves the next event of a source, if any.
+        /// The spill buffer is read only when the fifo is empty, since its events were pushed after the fifo's.
+        bool pop(std::size_t source, Event& event) {
+            auto& fifo = _fifos[source];
+            switch (_policies[source].strategy) {
+                case overflow::drop_oldest: {
+                    std::size_t position;
+                    if (pop_ring_concurrent(fifo, event, position)) {
+                        update_high_water_mark(fifo, position);
+                        return true;
+                    }
+                    return false;
+                }
+                case overflow::spill: {
+                    if (pop_ring(fifo, event)) {
+                        return true;
+                    }
+                    if (fifo.spilled.load(std::memory_order_acquire) == 0) {
+                        return false;
+                    }
+                    std::lock_guard<std::mutex> lock(fifo.spill_mutex);
+                    if (pop_ring(fifo, event)) {
+                        return true;
+                    }
+                    event = fifo.spill.front();
+                    fifo.spill.pop_front();
+                    fifo.spilled.store(fifo.spill.size(), std::memory_order_release);
+                    return true;
+                }
+                default:
+                    return pop_ring(fifo, event);
+            }
+        }
+
         const std::size_t _fifo_size;
         const std::chrono::high_resolution_clock::duration _sleep_duration;
+        const std::array<overflow_policy, sources> _policies;
+        const dispatch_placement _placement;
+        placement_report _report;
         HandleEvent _handle_event;
         std::array<fifo, sources> _fifos;
         std::array<std::pair<Event, bool>, sources> _next_events_and_exists;
@@ -149,4 +580,34 @@ namespace tarsier {
         return std::unique_ptr<merge<sources, Event, HandleEvent>>(
             new merge<sources, Event, HandleEvent>(fifo_size, sleep_duration, std::forward<HandleEvent>(handle_event)));
     }
+
+    /// make_merge creates a merge with overflow policies from a functor.
+    template <std::size_t sources, typename Event, typename HandleEvent>
+    inline std::unique_ptr<merge<sources, Event, HandleEvent>> make_merge(
+        std::size_t fifo_size,
+        std::chrono::high_resolution_clock::duration sleep_duration,
+        const std::array<overflow_policy, sources>& policies,
+        HandleEvent&& handle_event) {
+        return std::unique_ptr<merge<sources, Event, HandleEvent>>(new merge<sources, Event, HandleEvent>(
+            fifo_size,
+            sleep_duration,
+            policies,
+            std::forward<HandleEvent>(handle_event)));
+    }
+
+    /// make_merge creates a merge with overflow policies and a dispatch placement from a functor.
+    template <std::size_t sources, typename Event, typename HandleEvent>
+    inline std::unique_ptr<merge<sources, Event, HandleEvent>> make_merge(
+        std::size_t fifo_size,
+        std::chrono::high_resolution_clock::duration sleep_duration,
+        const std::array<overflow_policy, sources>& policies,
+        dispatch_placement placement,
+        HandleEvent&& handle_event) {
+        return std::unique_ptr<merge<sources, Event, HandleEvent>>(new merge<sources, Event, HandleEvent>(
+            fifo_size,
+            sleep_duration,
+            policies,
+            placement,
+            std::forward<HandleEvent>(handle_event)));
+    }
 }
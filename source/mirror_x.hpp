@@ -35,4 +35,31 @@ namespace tarsier {
     inline mirror_x<Event, HandleEvent> make_mirror_x(uint16_t width, HandleEvent&& handle_event) {
         return mirror_x<Event, HandleEvent>(width, std::forward<HandleEvent>(handle_event));
     }
+
+    /// static_mirror_x inverts the x coordinate, with the width known at compile time.
+    template <typename Event, uint16_t width, typename HandleEvent>
+    class static_mirror_x {
+        public:
+        static_mirror_x(HandleEvent&& handle_event) : _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        static_mirror_x(const static_mirror_x&) = delete;
+        static_mirror_x(static_mirror_x&&) = default;
+        static_mirror_x& operator=(const static_mirror_x&) = delete;
+        static_mirror_x& operator=(static_mirror_x&&) = default;
+        virtual ~static_mirror_x() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            event.x = width - 1 - event.x;
+            _handle_event(event);
+        }
+
+        protected:
+        HandleEvent _handle_event;
+    };
+
+    /// make_mirror_x creates a static_mirror_x from a functor.
+    template <typename Event, uint16_t width, typename HandleEvent>
+    inline static_mirror_x<Event, width, HandleEvent> make_mirror_x(HandleEvent&& handle_event) {
+        return static_mirror_x<Event, width, HandleEvent>(std::forward<HandleEvent>(handle_event));
+    }
 }
@@ -35,4 +35,31 @@ namespace tarsier {
     inline mirror_y<Event, HandleEvent> make_mirror_y(uint16_t height, HandleEvent&& handle_event) {
         return mirror_y<Event, HandleEvent>(height, std::forward<HandleEvent>(handle_event));
     }
+
+    /// static_mirror_y inverts the y coordinate, with the height known at compile time.
+    template <typename Event, uint16_t height, typename HandleEvent>
+    class static_mirror_y {
+        public:
+        static_mirror_y(HandleEvent&& handle_event) : _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        static_mirror_y(const static_mirror_y&) = delete;
+        static_mirror_y(static_mirror_y&&) = default;
+        static_mirror_y& operator=(const static_mirror_y&) = delete;
+        static_mirror_y& operator=(static_mirror_y&&) = default;
+        virtual ~static_mirror_y() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            event.y = height - 1 - event.y;
+            _handle_event(event);
+        }
+
+        protected:
+        HandleEvent _handle_event;
+    };
+
+    /// make_mirror_y creates a static_mirror_y from a functor.
+    template <typename Event, uint16_t height, typename HandleEvent>
+    inline static_mirror_y<Event, height, HandleEvent> make_mirror_y(HandleEvent&& handle_event) {
+        return static_mirror_y<Event, height, HandleEvent>(std::forward<HandleEvent>(handle_event));
+    }
 }
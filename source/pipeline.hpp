@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+    /// indices is a compile-time list of tuple indices.
+    template <std::size_t... Indices>
+    struct indices {};
+
+    /// make_indices generates the list of indices in the integer range [0, size[.
+    template <std::size_t size, std::size_t... Indices>
+    struct make_indices : make_indices<size - 1, size - 1, Indices...> {};
+    template <std::size_t... Indices>
+    struct make_indices<0, Indices...> {
+        typedef indices<Indices...> type;
+    };
+
+    /// last_type is the last type of a parameter pack, or void if the pack is empty.
+    template <typename... Types>
+    struct last_type {
+        typedef void type;
+    };
+    template <typename Type>
+    struct last_type<Type> {
+        typedef Type type;
+    };
+    template <typename Type, typename... Types>
+    struct last_type<Type, Types...> : last_type<Types...> {};
+
+    /// specialise_event specialises handlers with the signature Handler<Event, HandleEvent>.
+    template <template <typename, typename> class Handler, typename Event>
+    struct specialise_event {
+        template <typename Last, typename HandleEvent>
+        using handler = Handler<Event, HandleEvent>;
+    };
+
+    /// specialise_event_and_mapping specialises handlers with the signature
+    /// Handler<Event, EventToOutput, HandleOutput>, where EventToOutput is the last constructor parameter.
+    template <template <typename, typename, typename> class Handler, typename Event>
+    struct specialise_event_and_mapping {
+        template <typename Last, typename HandleEvent>
+        using handler = Handler<Event, Last, HandleEvent>;
+    };
+
+    /// specialise_event_output_and_mapping specialises handlers with the signature
+    /// Handler<Event, Output, EventToOutput, HandleOutput>, where EventToOutput is the last constructor parameter.
+    template <template <typename, typename, typename, typename> class Handler, typename Event, typename Output>
+    struct specialise_event_output_and_mapping {
+        template <typename Last, typename HandleEvent>
+        using handler = Handler<Event, Output, Last, HandleEvent>;
+    };
+
+    /// stage_base tags the types that can be composed with operator|.
+    struct stage_base {};
+
+    /// stage stores the constructor parameters of a handler, except for its event callback.
+    /// The handler is built once the next stage (or the final callback) is known.
+    template <typename Specialiser, typename Event, typename... Parameters>
+    class stage : public stage_base {
+        public:
+        template <typename... ForwardedParameters>
+        stage(ForwardedParameters&&... parameters) :
+            _parameters(std::forward<ForwardedParameters>(parameters)...) {}
+        stage(const stage&) = delete;
+        stage(stage&&) = default;
+        stage& operator=(const stage&) = delete;
+        stage& operator=(stage&&) = default;
+        ~stage() = default;
+
+        /// event_type is the type of the events handled by this stage.
+        typedef Event event_type;
+
+        /// handler is the type of the handler built by bind.
+        template <typename HandleEvent>
+        using handler = typename Specialiser::template handler<typename last_type<Parameters...>::type, HandleEvent>;
+
+        /// bind creates the handler, consuming the stored parameters.
+        /// It is rvalue-qualified since the parameters are moved into the handler.
+        template <typename HandleEvent>
+        handler<HandleEvent> bind(HandleEvent&& handle_event) && {
+            return bind(typename make_indices<sizeof...(Parameters)>::type(), std::forward<HandleEvent>(handle_event));
+        }
+
+        protected:
+        /// bind unpacks the stored parameters.
+        template <std::size_t... Indices, typename HandleEvent>
+        handler<HandleEvent> bind(indices<Indices...>, HandleEvent&& handle_event) {
+            return handler<HandleEvent>(
+                std::move(std::get<Indices>(_parameters))..., std::forward<HandleEvent>(handle_event));
+        }
+
+        std::tuple<Parameters...> _parameters;
+    };
+
+    /// chain composes two stages, the second one handling the output of the first one.
+    template <typename FirstStage, typename SecondStage>
+    class chain : public stage_base {
+        public:
+        chain(FirstStage&& first_stage, SecondStage&& second_stage) :
+            _first_stage(std::forward<FirstStage>(first_stage)),
+            _second_stage(std::forward<SecondStage>(second_stage)) {}
+        chain(const chain&) = delete;
+        chain(chain&&) = default;
+        chain& operator=(const chain&) = delete;
+        chain& operator=(chain&&) = default;
+        ~chain() = default;
+
+        /// event_type is the type of the events handled by the first stage.
+        typedef typename FirstStage::event_type event_type;
+
+        /// bind creates the nested handlers, consuming the stored stages.
+        template <typename HandleEvent>
+        auto bind(HandleEvent&& handle_event) && -> decltype(std::declval<FirstStage>().bind(
+            std::declval<SecondStage>().bind(std::forward<HandleEvent>(handle_event)))) {
+            return std::move(_first_stage).bind(std::move(_second_stage).bind(std::forward<HandleEvent>(handle_event)));
+        }
+
+        protected:
+        FirstStage _first_stage;
+        SecondStage _second_stage;
+    };
+
+    /// pipeline wraps a chain of nested handlers into a final, non-virtual handler.
+    /// Since every handler stores the next one by value, the whole chain is a single type and
+    /// the compiler can inline it into the caller's loop.
+    template <typename Event, typename Handler>
+    class pipeline final {
+        public:
+        pipeline(Handler&& handler) : _handler(std::forward<Handler>(handler)) {}
+        pipeline(const pipeline&) = delete;
+        pipeline(pipeline&&) = default;
+        pipeline& operator=(const pipeline&) = delete;
+        pipeline& operator=(pipeline&&) = default;
+        ~pipeline() = default;
+
+        /// operator() handles an event.
+        void operator()(Event event) {
+            _handler.handler_type::operator()(event);
+        }
+
+        /// operator() handles the events in the range [begin, end[.
+        template <typename Iterator>
+        void operator()(Iterator begin, Iterator end) {
+            for (; begin != end; ++begin) {
+                _handler.handler_type::operator()(*begin);
+            }
+        }
+
+        protected:
+        /// handler_type is the handler type without reference, used for non-virtual calls.
+        typedef typename std::remove_reference<Handler>::type handler_type;
+
+        Handler _handler;
+    };
+
+    /// make_stage creates a stage for a handler with the signature Handler<Event, HandleEvent>.
+    template <template <typename, typename> class Handler, typename Event, typename... Parameters>
+    inline stage<specialise_event<Handler, Event>, Event, typename std::decay<Parameters>::type...>
+    make_stage(Parameters&&... parameters) {
+        return stage<specialise_event<Handler, Event>, Event, typename std::decay<Parameters>::type...>(
+            std::forward<Parameters>(parameters)...);
+    }
+
+    /// make_stage creates a stage for a handler with the signature Handler<Event, EventToOutput, HandleOutput>.
+    template <template <typename, typename, typename> class Handler, typename Event, typename... Parameters>
+    inline stage<specialise_event_and_mapping<Handler, Event>, Event, typename std::decay<Parameters>::type...>
+    make_stage(Parameters&&... parameters) {
+        return stage<specialise_event_and_mapping<Handler, Event>, Event, typename std::decay<Parameters>::type...>(
+            std::forward<Parameters>(parameters)...);
+    }
+
+    /// make_stage creates a stage for a handler with the signature Handler<Event, Output, EventToOutput, HandleOutput>.
+    template <
+        template <typename, typename, typename, typename> class Handler,
+        typename Event,
+        typename Output,
+        typename... Parameters>
+    inline stage<
+        specialise_event_output_and_mapping<Handler, Event, Output>,
+        Event,
+        typename std::decay<Parameters>::type...>
+    make_stage(Parameters&&... parameters) {
+        return stage<
+            specialise_event_output_and_mapping<Handler, Event, Output>,
+            Event,
+            typename std::decay<Parameters>::type...>(std::forward<Parameters>(parameters)...);
+    }
+
+    /// make_pipeline creates a pipeline from a handler.
+    template <typename Event, typename Handler>
+    inline pipeline<Event, Handler> make_pipeline(Handler&& handler) {
+        return pipeline<Event, Handler>(std::forward<Handler>(handler));
+    }
+
+    /// operator| composes two stages.
+    /// Stages cannot be copied, hence a named stage must be passed with std::move.
+    template <
+        typename FirstStage,
+        typename SecondStage,
+        typename = typename std::enable_if<
+            std::is_base_of<stage_base, typename std::decay<FirstStage>::type>::value
+            && std::is_base_of<stage_base, typename std::decay<SecondStage>::type>::value>::type>
+    inline chain<typename std::decay<FirstStage>::type, typename std::decay<SecondStage>::type>
+    operator|(FirstStage&& first_stage, SecondStage&& second_stage) {
+        return chain<typename std::decay<FirstStage>::type, typename std::decay<SecondStage>::type>(
+            std::forward<FirstStage>(first_stage), std::forward<SecondStage>(second_stage));
+    }
+
+    /// operator| terminates a chain of stages with an event callback, and creates a pipeline.
+    template <
+        typename Stage,
+        typename HandleEvent,
+        typename = typename std::enable_if<
+            std::is_base_of<stage_base, typename std::decay<Stage>::type>::value
+            && !std::is_base_of<stage_base, typename std::decay<HandleEvent>::type>::value>::type>
+    inline pipeline<
+        typename std::decay<Stage>::type::event_type,
+        decltype(std::declval<typename std::decay<Stage>::type>().bind(std::declval<HandleEvent>()))>
+    operator|(Stage&& stage, HandleEvent&& handle_event) {
+        return make_pipeline<typename std::decay<Stage>::type::event_type>(
+            std::forward<Stage>(stage).bind(std::forward<HandleEvent>(handle_event)));
+    }
+}
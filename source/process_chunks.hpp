@@ -0,0 +1,281 @@
+#pragma once
+
+#include "event_stream.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// chunk_output collects the outputs of a chunk's handler, and ignores them during the warm-up.
+    template <typename Output>
+    class chunk_output {
+        public:
+        chunk_output(std::vector<Output>& outputs, const bool& warming_up) :
+            _outputs(outputs),
+            _warming_up(warming_up) {}
+        chunk_output(const chunk_output&) = default;
+        chunk_output(chunk_output&&) = default;
+        chunk_output& operator=(const chunk_output&) = delete;
+        chunk_output& operator=(chunk_output&&) = delete;
+        virtual ~chunk_output() = default;
+
+        /// operator() handles an output.
+        virtual void operator()(Output output) {
+            if (!_warming_up) {
+                _outputs.push_back(output);
+            }
+        }
+
+        protected:
+        std::vector<Output>& _outputs;
+        const bool& _warming_up;
+    };
+
+    /// chunk_feeder passes events to a chunk's handler, whatever the events' type.
+    template <typename Handler>
+    class chunk_feeder {
+        public:
+        chunk_feeder(Handler& handler) : _handler(handler) {}
+
+        /// operator() handles an event.
+        template <typename Event>
+        void operator()(Event event) {
+            _handler(event);
+        }
+
+        protected:
+        Handler& _handler;
+    };
+
+    /// vector_range reads the events of a vector whose timestamps are in a given range.
+    template <typename Event>
+    class vector_range {
+        public:
+        vector_range(const std::vector<Event>& events) : _events(events) {}
+
+        /// operator() passes the events whose timestamps are in the range [begin_t, end_t[.
+        template <typename HandleEvent>
+        void operator()(uint64_t begin_t, uint64_t end_t, HandleEvent&& handle_event) const {
+            const auto compare = [](const Event& event, uint64_t t) { return event.t < t; };
+            const auto end = std::lower_bound(_events.begin(), _events.end(), end_t, compare);
+            for (auto event_iterator = std::lower_bound(_events.begin(), end, begin_t, compare);
+                 event_iterator != end;
+                 ++event_iterator) {
+                handle_event(*event_iterator);
+            }
+        }
+
+        protected:
+        const std::vector<Event>& _events;
+    };
+
+    /// stream_range reads the events of a stream file whose timestamps are in a given range.
+    /// Each call maps the file and seeks the first block, so that concurrent calls are independent.
+    template <typename Event>
+    class stream_range {
+        public:
+        stream_range(const std::string& filename) : _filename(filename) {}
+
+        /// operator() passes the events whose timestamps are in the range [begin_t, end_t[.
+        template <typename HandleEvent>
+        void operator()(uint64_t begin_t, uint64_t end_t, HandleEvent&& handle_event) const {
+            read_stream<Event> stream(_filename);
+            stream.seek(begin_t);
+            auto ended = false;
+            while (!ended && stream.read_block([&](const Event* begin, const Event* end) {
+                for (; begin != end; ++begin) {
+                    if (begin->t >= end_t) {
+                        ended = true;
+                        return;
+                    }
+                    handle_event(*begin);
+                }
+            })) {
+            }
+        }
+
+        protected:
+        const std::string _filename;
+    };
+
+    /// process_chunks splits the time range [first_t, last_t] into chunks, and handles each chunk
+    /// with its own handler on a pool of threads.
+    /// make_handler is called once per chunk, possibly concurrently, with a chunk_output,
+    /// and must return a handler that sends its outputs to it.
+    /// Each handler first receives the events of the warm_up preceding its chunk, so that stateful handlers
+    /// reach the state they would have in a sequential run. The outputs generated during the warm-up are ignored.
+    /// read_range(begin_t, end_t, handle_event) must pass the events whose timestamps are in [begin_t, end_t[,
+    /// and must support concurrent calls.
+    /// The outputs are passed to handle_output on the calling thread, in chunk order.
+    /// At most two chunks per thread are buffered, and an exception thrown by a chunk is rethrown by process_chunks.
+    template <typename Output, typename ReadRange, typename MakeHandler, typename HandleOutput>
+    inline void process_chunks(
+        uint64_t first_t,
+        uint64_t last_t,
+        uint64_t chunk_duration,
+        uint64_t warm_up,
+        std::size_t threads,
+        ReadRange read_range,
+        MakeHandler make_handler,
+        HandleOutput handle_output) {
+        if (chunk_duration == 0) {
+            throw std::logic_error("chunk_duration must be larger than 0");
+        }
+        if (last_t < first_t) {
+            return;
+        }
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency() == 0 ? 1 : std::thread::hardware_concurrency();
+        }
+        const auto chunks = static_cast<std::size_t>((last_t - first_t) / chunk_duration + 1);
+        const auto slots = threads * 2;
+        std::vector<std::vector<Output>> outputs(slots);
+        std::vector<std::size_t> completed(slots, std::numeric_limits<std::size_t>::max());
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::size_t next_chunk = 0;
+        std::size_t emitted = 0;
+        auto failed = false;
+        std::exception_ptr exception;
+        const auto fail = [&]() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!failed) {
+                    failed = true;
+                    exception = std::current_exception();
+                }
+            }
+            condition.notify_all();
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t index = 0; index < threads; ++index) {
+            workers.emplace_back([&]() {
+                for (;;) {
+                    std::size_t chunk;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        condition.wait(lock, [&]() {
+                            return failed || next_chunk >= chunks || next_chunk < emitted + slots;
+                        });
+                        if (failed || next_chunk >= chunks) {
+                            return;
+                        }
+                        chunk = next_chunk;
+                        ++next_chunk;
+                    }
+                    auto& chunk_outputs = outputs[chunk % slots];
+                    chunk_outputs.clear();
+                    try {
+                        const auto begin_t = first_t + chunk * chunk_duration;
+                        const auto end_t = chunk == chunks - 1 ? last_t + 1 : begin_t + chunk_duration;
+                        auto warming_up = true;
+                        auto handler = make_handler(chunk_output<Output>(chunk_outputs, warming_up));
+                        chunk_feeder<decltype(handler)> feeder(handler);
+                        read_range(begin_t - std::min(warm_up, begin_t - first_t), begin_t, feeder);
+                        warming_up = false;
+                        read_range(begin_t, end_t, feeder);
+                    } catch (...) {
+                        fail();
+                        return;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        completed[chunk % slots] = chunk;
+                    }
+                    condition.notify_all();
+                }
+            });
+        }
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() { return failed || completed[chunk % slots] == chunk; });
+                if (failed) {
+                    break;
+                }
+            }
+            try {
+                for (const auto& output : outputs[chunk % slots]) {
+                    handle_output(output);
+                }
+            } catch (...) {
+                fail();
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++emitted;
+            }
+            condition.notify_all();
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    /// process_chunks handles the events of a vector in chunks.
+    template <typename Output, typename Event, typename MakeHandler, typename HandleOutput>
+    inline void process_chunks(
+        const std::vector<Event>& events,
+        uint64_t chunk_duration,
+        uint64_t warm_up,
+        std::size_t threads,
+        MakeHandler make_handler,
+        HandleOutput handle_output) {
+        if (events.empty()) {
+            return;
+        }
+        process_chunks<Output>(
+            events.front().t,
+            events.back().t,
+            chunk_duration,
+            warm_up,
+            threads,
+            vector_range<Event>(events),
+            std::move(make_handler),
+            std::move(handle_output));
+    }
+
+    /// process_chunks handles the events of a stream file in chunks.
+    template <typename Output, typename Event, typename MakeHandler, typename HandleOutput>
+    inline void process_chunks(
+        const std::string& filename,
+        uint64_t chunk_duration,
+        uint64_t warm_up,
+        std::size_t threads,
+        MakeHandler make_handler,
+        HandleOutput handle_output) {
+        uint64_t first_t;
+        uint64_t last_t;
+        {
+            read_stream<Event> stream(filename);
+            if (stream.number_of_events() == 0) {
+                return;
+            }
+            first_t = stream.first_t();
+            last_t = stream.last_t();
+        }
+        process_chunks<Output>(
+            first_t,
+            last_t,
+            chunk_duration,
+            warm_up,
+            threads,
+            stream_range<Event>(filename),
+            std::move(make_handler),
+            std::move(handle_output));
+    }
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "event_stream.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// replay_statistics summarises the state of a replay.
+    struct replay_statistics {
+        /// events is the number of events dispatched so far.
+        uint64_t events;
+
+        /// dropped is the number of events rejected by the handler (a false return value, as with merge::push).
+        uint64_t dropped;
+
+        /// elapsed is the wall-clock time since the first event was dispatched.
+        std::chrono::steady_clock::duration elapsed;
+
+        /// lag is the delay between the last event's scheduled and actual dispatch times.
+        std::chrono::steady_clock::duration lag;
+
+        /// maximum_lag is the largest lag observed so far.
+        std::chrono::steady_clock::duration maximum_lag;
+
+        /// finished is true once all the events have been dispatched.
+        bool finished;
+
+        /// rate returns the achieved number of events per second.
+        double rate() const {
+            const auto seconds = std::chrono::duration<double>(elapsed).count();
+            return seconds > 0 ? events / seconds : 0.0;
+        }
+    };
+
+    /// replay dispatches the events of a stream file, either as fast as possible or paced by their timestamps.
+    /// Events are decoded on one thread and dispatched on another, through a lock-free fifo.
+    /// Timestamps are interpreted as microseconds, and a speed of 2 replays the recording twice as fast.
+    /// A speed of 0 dispatches the events as fast as possible.
+    template <typename Event, typename HandleEvent>
+    class replay {
+        public:
+        replay(read_stream<Event>&& stream, double speed, std::size_t fifo_size, HandleEvent&& handle_event) :
+            _stream(std::move(stream)),
+            _speed(speed),
+            _fifo_size(fifo_size),
+            _handle_event(std::forward<HandleEvent>(handle_event)),
+            _events(fifo_size),
+            _head(0),
+            _tail(0),
+            _running(true),
+            _decoded(false),
+            _finished(false),
+            _dispatched(0),
+            _dropped(0),
+            _elapsed(0),
+            _lag(0),
+            _maximum_lag(0),
+            _exception(nullptr) {
+            if (_speed < 0) {
+                throw std::logic_error("speed must be positive or zero");
+            }
+            if (_fifo_size < 2) {
+                throw std::logic_error("fifo_size must be larger than 1");
+            }
+            _decode = std::thread([this]() {
+                auto tail = _tail.load(std::memory_order_relaxed);
+                try {
+                    while (_running.load(std::memory_order_acquire)
+                           && _stream.read_block([&](const Event* begin, const Event* end) {
+                                  for (; begin != end; ++begin) {
+                                      const auto next_tail = (tail + 1) % _fifo_size;
+                                      std::size_t attempts = 0;
+                                      while (next_tail == _head.load(std::memory_order_acquire)) {
+                                          if (!_running.load(std::memory_order_acquire)) {
+                                              return;
+                                          }
+                                          back_off(attempts);
+                                      }
+                                      _events[tail] = *begin;
+                                      tail = next_tail;
+                                      _tail.store(tail, std::memory_order_release);
+                                  }
+                              })) {
+                    }
+                } catch (...) {
+                    // the exception (for instance a corrupted block) is rethrown by wait
+                    _exception = std::current_exception();
+                }
+                _decoded.store(true, std::memory_order_release);
+            });
+            _dispatch = std::thread([this]() {
+                auto head = _head.load(std::memory_order_relaxed);
+                auto first = true;
+                uint64_t first_t = 0;
+                std::chrono::steady_clock::time_point start;
+                std::size_t attempts = 0;
+                for (;;) {
+                    const auto decoded = _decoded.load(std::memory_order_acquire);
+                    const auto tail = _tail.load(std::memory_order_acquire);
+                    if (head == tail) {
+                        if (decoded || !_running.load(std::memory_order_acquire)) {
+                            break;
+                        }
+                        back_off(attempts);
+                        continue;
+                    }
+                    attempts = 0;
+                    for (; head != tail; head = (head + 1) % _fifo_size) {
+                        const auto event = _events[head];
+                        if (first) {
+                            first = false;
+                            first_t = event.t;
+                            start = std::chrono::steady_clock::now();
+                        }
+                        auto now = std::chrono::steady_clock::now();
+                        if (_speed > 0) {
+                            const auto scheduled =
+                                start
+                                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double, std::micro>((event.t - first_t) / _speed));
+                            if (now < scheduled) {
+                                if (scheduled - now > std::chrono::microseconds(200)) {
+                                    std::this_thread::sleep_until(scheduled - std::chrono::microseconds(100));
+                                }
+                                while (now < scheduled) {
+                                    now = std::chrono::steady_clock::now();
+                                }
+                            }
+                            const auto lag = (now - scheduled).count();
+                            _lag.store(lag, std::memory_order_relaxed);
+                            if (lag > _maximum_lag.load(std::memory_order_relaxed)) {
+                                _maximum_lag.store(lag, std::memory_order_relaxed);
+                            }
+                        }
+                        if (!dispatch(event, std::is_same<decltype(_handle_event(event)), bool>())) {
+                            _dropped.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        _dispatched.fetch_add(1, std::memory_order_relaxed);
+                        _elapsed.store((now - start).count(), std::memory_order_relaxed);
+                        if (((head + 1) & 0xff) == 0) {
+                            _head.store((head + 1) % _fifo_size, std::memory_order_release);
+                        }
+                    }
+                    _head.store(head, std::memory_order_release);
+                }
+                _finished.store(true, std::memory_order_release);
+            });
+        }
+        replay(const replay&) = delete;
+        replay(replay&&) = delete;
+        replay& operator=(const replay&) = delete;
+        replay& operator=(replay&&) = delete;
+        virtual ~replay() {
+            _running.store(false, std::memory_order_release);
+            _decode.join();
+            _dispatch.join();
+        }
+
+        /// wait blocks until all the events have been dispatched.
+        /// If decoding failed, it rethrows the decoder's exception once the events decoded before the failure
+        /// have been dispatched.
+        void wait() {
+            while (!_finished.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (_exception) {
+                std::rethrow_exception(_exception);
+            }
+        }
+
+        /// statistics returns the current state of the replay, and can be called from any thread.
+        replay_statistics statistics() const {
+            return replay_statistics{
+                _dispatched.load(std::memory_order_relaxed),
+                _dropped.load(std::memory_order_relaxed),
+                std::chrono::steady_clock::duration(_elapsed.load(std::memory_order_relaxed)),
+                std::chrono::steady_clock::duration(_lag.load(std::memory_order_relaxed)),
+                std::chrono::steady_clock::duration(_maximum_lag.load(std::memory_order_relaxed)),
+                _finished.load(std::memory_order_acquire),
+            };
+        }
+
+        protected:
+        /// back_off waits before a thread polls the fifo again. It yields for the first attempts, then sleeps for a
+        /// duration that doubles up to about a millisecond, so that a stalled thread does not keep a core busy.
+        static void back_off(std::size_t& attempts) {
+            if (attempts < 16) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(1 << std::min<std::size_t>(attempts - 16, 10)));
+            }
+            ++attempts;
+        }
+
+        /// dispatch calls a handler that returns a boolean, false meaning that the event was dropped.
+        bool dispatch(Event event, std::true_type) {
+            return _handle_event(event);
+        }
+
+        /// dispatch calls a handler without return value.
+        bool dispatch(Event event, std::false_type) {
+            _handle_event(event);
+            return true;
+        }
+
+        read_stream<Event> _stream;
+        const double _speed;
+        const std::size_t _fifo_size;
+        HandleEvent _handle_event;
+        std::vector<Event> _events;
+        std::atomic<std::size_t> _head;
+        std::atomic<std::size_t> _tail;
+        std::atomic_bool _running;
+        std::atomic_bool _decoded;
+        std::atomic_bool _finished;
+        std::atomic<uint64_t> _dispatched;
+        std::atomic<uint64_t> _dropped;
+        std::atomic<int64_t> _elapsed;
+        std::atomic<int64_t> _lag;
+        std::atomic<int64_t> _maximum_lag;
+        std::exception_ptr _exception;
+        std::thread _decode;
+        std::thread _dispatch;
+    };
+
+    /// make_replay creates a replay from a stream and a functor.
+    template <typename Event, typename HandleEvent>
+    inline std::unique_ptr<replay<Event, HandleEvent>>
+    make_replay(read_stream<Event>&& stream, double speed, std::size_t fifo_size, HandleEvent&& handle_event) {
+        return std::unique_ptr<replay<Event, HandleEvent>>(
+            new replay<Event, HandleEvent>(
+                std::move(stream), speed, fifo_size, std::forward<HandleEvent>(handle_event)));
+    }
+}
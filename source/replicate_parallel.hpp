@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// backpressure lists the behaviours of replicate_parallel when a branch's fifo is full.
+    enum class backpressure {
+        /// block waits until the branch has room for the event.
+        block,
+
+        /// drop discards the event for this branch.
+        drop,
+
+        /// count discards the event for this branch, and increments its dropped counter.
+        count,
+    };
+
+    /// replicate_parallel triggers several handlers for each event, each one on its own thread.
+    /// Events are copied into a bounded single-producer single-consumer fifo per branch,
+    /// and each branch's thread handles the events available in its fifo as a batch.
+    /// operator() must be called from a single thread.
+    template <typename Event, typename... HandleEventCallbacks>
+    class replicate_parallel {
+        public:
+        replicate_parallel(
+            std::size_t fifo_size,
+            std::chrono::high_resolution_clock::duration sleep_duration,
+            backpressure policy,
+            HandleEventCallbacks&&... handle_event_callbacks) :
+            _fifo_size(fifo_size),
+            _sleep_duration(sleep_duration),
+            _policy(policy),
+            _handle_event_callbacks(std::forward<HandleEventCallbacks>(handle_event_callbacks)...),
+            _running(true) {
+            if (_fifo_size < 2) {
+                throw std::logic_error("fifo_size must be larger than 1");
+            }
+            for (auto& fifo : _fifos) {
+                fifo.events.resize(_fifo_size);
+                fifo.head.store(0, std::memory_order_release);
+                fifo.tail.store(0, std::memory_order_release);
+                fifo.cached_head = 0;
+                fifo.dropped.store(0, std::memory_order_release);
+            }
+            start<0>();
+        }
+        replicate_parallel(const replicate_parallel&) = delete;
+        replicate_parallel(replicate_parallel&&) = delete;
+        replicate_parallel& operator=(const replicate_parallel&) = delete;
+        replicate_parallel& operator=(replicate_parallel&&) = delete;
+        virtual ~replicate_parallel() {
+            _running.store(false, std::memory_order_release);
+            for (auto& loop : _loops) {
+                loop.join();
+            }
+        }
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            for (auto& fifo : _fifos) {
+                const auto current_tail = fifo.tail.load(std::memory_order_relaxed);
+                const auto next_tail = (current_tail + 1) % _fifo_size;
+                if (next_tail == fifo.cached_head) {
+                    fifo.cached_head = fifo.head.load(std::memory_order_acquire);
+                    if (next_tail == fifo.cached_head) {
+                        switch (_policy) {
+                            case backpressure::block:
+                                do {
+                                    std::this_thread::yield();
+                                    fifo.cached_head = fifo.head.load(std::memory_order_acquire);
+                                } while (next_tail == fifo.cached_head);
+                                break;
+                            case backpressure::drop:
+                                continue;
+                            case backpressure::count:
+                                fifo.dropped.fetch_add(1, std::memory_order_relaxed);
+                                continue;
+                        }
+                    }
+                }
+                fifo.events[current_tail] = event;
+                fifo.tail.store(next_tail, std::memory_order_release);
+            }
+        }
+
+        /// dropped returns the number of events dropped by the given branch.
+        /// It is only updated with the count policy, and can be called from any thread.
+        std::size_t dropped(std::size_t branch) const {
+            return _fifos[branch].dropped.load(std::memory_order_relaxed);
+        }
+
+        protected:
+        /// fifo stores the variables of a thread-safe fifo.
+        /// head and tail are written by different threads, and are kept on different cache lines.
+        struct fifo {
+            std::vector<Event> events;
+            uint8_t padding_0[64];
+            std::atomic<std::size_t> head;
+            uint8_t padding_1[64];
+            std::atomic<std::size_t> tail;
+            std::size_t cached_head;
+            std::atomic<std::size_t> dropped;
+            uint8_t padding_2[64];
+        };
+
+        /// start creates the n-th branch's thread.
+        template <std::size_t index>
+        typename std::enable_if<(index < sizeof...(HandleEventCallbacks)), void>::type start() {
+            _loops[index] = std::thread([this]() {
+                auto& fifo = _fifos[index];
+                for (;;) {
+                    const auto running = _running.load(std::memory_order_acquire);
+                    auto current_head = fifo.head.load(std::memory_order_relaxed);
+                    const auto current_tail = fifo.tail.load(std::memory_order_acquire);
+                    if (current_head == current_tail) {
+                        if (!running) {
+                            break;
+                        }
+                        std::this_thread::sleep_for(_sleep_duration);
+                        continue;
+                    }
+                    while (current_head != current_tail) {
+                        std::get<index>(_handle_event_callbacks)(fifo.events[current_head]);
+                        current_head = (current_head + 1) % _fifo_size;
+                    }
+                    fifo.head.store(current_head, std::memory_order_release);
+                }
+            });
+            start<index + 1>();
+        }
+
+        /// start is a termination for the template loop.
+        template <std::size_t index>
+        typename std::enable_if<index == sizeof...(HandleEventCallbacks), void>::type start() {}
+
+        const std::size_t _fifo_size;
+        const std::chrono::high_resolution_clock::duration _sleep_duration;
+        const backpressure _policy;
+        std::tuple<HandleEventCallbacks...> _handle_event_callbacks;
+        std::array<fifo, sizeof...(HandleEventCallbacks)> _fifos;
+        std::array<std::thread, sizeof...(HandleEventCallbacks)> _loops;
+        std::atomic_bool _running;
+    };
+
+    /// make_replicate_parallel creates a replicate_parallel from functors.
+    template <typename Event, typename... HandleEventCallbacks>
+    inline std::unique_ptr<replicate_parallel<Event, HandleEventCallbacks...>> make_replicate_parallel(
+        std::size_t fifo_size,
+        std::chrono::high_resolution_clock::duration sleep_duration,
+        backpressure policy,
+        HandleEventCallbacks&&... handle_event_callbacks) {
+        return std::unique_ptr<replicate_parallel<Event, HandleEventCallbacks...>>(
+            new replicate_parallel<Event, HandleEventCallbacks...>(
+                fifo_size, sleep_duration, policy, std::forward<HandleEventCallbacks>(handle_event_callbacks)...));
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <utility>
 
 /// tarsier is a collection of event handlers.
@@ -41,4 +42,35 @@ namespace tarsier {
     make_select_disk(float x, float y, float radius, HandleEvent&& handle_event) {
         return select_disk<Event, HandleEvent>(x, y, radius, std::forward<HandleEvent>(handle_event));
     }
+
+    /// static_select_disk propagates only the events within the given disk, known
+    /// at compile time.
+    template <typename Event, uint16_t x, uint16_t y, uint16_t radius, typename HandleEvent>
+    class static_select_disk {
+        public:
+        static_select_disk(HandleEvent&& handle_event) : _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        static_select_disk(const static_select_disk&) = delete;
+        static_select_disk(static_select_disk&&) = default;
+        static_select_disk& operator=(const static_select_disk&) = delete;
+        static_select_disk& operator=(static_select_disk&&) = default;
+        virtual ~static_select_disk() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto x_delta = static_cast<int32_t>(event.x) - x;
+            const auto y_delta = static_cast<int32_t>(event.y) - y;
+            if (x_delta * x_delta + y_delta * y_delta < static_cast<int32_t>(radius) * radius) {
+                _handle_event(event);
+            }
+        }
+
+        protected:
+        HandleEvent _handle_event;
+    };
+
+    /// make_select_disk creates a static_select_disk from a functor.
+    template <typename Event, uint16_t x, uint16_t y, uint16_t radius, typename HandleEvent>
+    inline static_select_disk<Event, x, y, radius, HandleEvent> make_select_disk(HandleEvent&& handle_event) {
+        return static_select_disk<Event, x, y, radius, HandleEvent>(std::forward<HandleEvent>(handle_event));
+    }
 }
@@ -49,4 +49,35 @@ namespace tarsier {
         return select_rectangle<Event, HandleEvent>(
             left, bottom, width, height, std::forward<HandleEvent>(handle_event));
     }
+
+    /// static_select_rectangle propagates only the events within the given
+    /// rectangular window, known at compile time.
+    template <typename Event, uint16_t left, uint16_t bottom, uint16_t width, uint16_t height, typename HandleEvent>
+    class static_select_rectangle {
+        public:
+        static_select_rectangle(HandleEvent&& handle_event) : _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        static_select_rectangle(const static_select_rectangle&) = delete;
+        static_select_rectangle(static_select_rectangle&&) = default;
+        static_select_rectangle& operator=(const static_select_rectangle&) = delete;
+        static_select_rectangle& operator=(static_select_rectangle&&) = default;
+        virtual ~static_select_rectangle() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            if (static_cast<uint32_t>(event.x) - left < width && static_cast<uint32_t>(event.y) - bottom < height) {
+                _handle_event(event);
+            }
+        }
+
+        protected:
+        HandleEvent _handle_event;
+    };
+
+    /// make_select_rectangle creates a static_select_rectangle from a functor.
+    template <typename Event, uint16_t left, uint16_t bottom, uint16_t width, uint16_t height, typename HandleEvent>
+    inline static_select_rectangle<Event, left, bottom, width, height, HandleEvent>
+    make_select_rectangle(HandleEvent&& handle_event) {
+        return static_select_rectangle<Event, left, bottom, width, height, HandleEvent>(
+            std::forward<HandleEvent>(handle_event));
+    }
 }
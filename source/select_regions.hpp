@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// region describes a rectangle, a disk or a polygon in pixel coordinates.
+    /// A pixel belongs to a region with the same semantics as select_rectangle and select_disk,
+    /// and with the even-odd rule for polygons.
+    class region {
+        public:
+        /// rectangle creates a rectangular region.
+        static region rectangle(uint16_t left, uint16_t bottom, uint16_t width, uint16_t height) {
+            region result(shape::rectangle);
+            result._points = {
+                {static_cast<float>(left), static_cast<float>(bottom)},
+                {static_cast<float>(left) + width, static_cast<float>(bottom) + height}};
+            return result;
+        }
+
+        /// disk creates a disk-shaped region.
+        static region disk(float x, float y, float radius) {
+            region result(shape::disk);
+            result._points = {{x, y}, {radius, radius}};
+            return result;
+        }
+
+        /// polygon creates a polygonal region from its vertices.
+        static region polygon(std::vector<std::pair<float, float>> vertices) {
+            if (vertices.size() < 3) {
+                throw std::logic_error("a polygon must have at least 3 vertices");
+            }
+            region result(shape::polygon);
+            result._points = std::move(vertices);
+            return result;
+        }
+
+        /// bounding_box returns the left, bottom, right and top bounds (inclusive) of the region,
+        /// clipped to the given sensor size.
+        std::pair<std::pair<uint16_t, uint16_t>, std::pair<uint16_t, uint16_t>>
+        bounding_box(uint16_t width, uint16_t height) const {
+            auto left = std::numeric_limits<float>::max();
+            auto bottom = std::numeric_limits<float>::max();
+            auto right = std::numeric_limits<float>::lowest();
+            auto top = std::numeric_limits<float>::lowest();
+            switch (_shape) {
+                case shape::rectangle:
+                    left = _points[0].first;
+                    bottom = _points[0].second;
+                    right = _points[1].first - 1;
+                    top = _points[1].second - 1;
+                    break;
+                case shape::disk:
+                    left = std::floor(_points[0].first - _points[1].first);
+                    bottom = std::floor(_points[0].second - _points[1].first);
+                    right = std::ceil(_points[0].first + _points[1].first);
+                    top = std::ceil(_points[0].second + _points[1].first);
+                    break;
+                case shape::polygon:
+                    for (const auto& point : _points) {
+                        left = std::min(left, std::floor(point.first));
+                        bottom = std::min(bottom, std::floor(point.second));
+                        right = std::max(right, std::ceil(point.first));
+                        top = std::max(top, std::ceil(point.second));
+                    }
+                    break;
+            }
+            const auto clip = [](float value, uint16_t size) -> uint16_t {
+                return static_cast<uint16_t>(std::max(0.0f, std::min(value, static_cast<float>(size) - 1)));
+            };
+            if (right < 0 || top < 0 || left > width - 1 || bottom > height - 1 || right < left || top < bottom) {
+                return {{1, 1}, {0, 0}};
+            }
+            return {{clip(left, width), clip(bottom, height)}, {clip(right, width), clip(top, height)}};
+        }
+
+        /// contains returns true if the given pixel belongs to the region.
+        bool contains(uint16_t x, uint16_t y) const {
+            switch (_shape) {
+                case shape::rectangle:
+                    return x >= _points[0].first && x < _points[1].first && y >= _points[0].second
+                           && y < _points[1].second;
+                case shape::disk: {
+                    const auto x_delta = x - _points[0].first;
+                    const auto y_delta = y - _points[0].second;
+                    return x_delta * x_delta + y_delta * y_delta < _points[1].first * _points[1].first;
+                }
+                case shape::polygon: {
+                    auto inside = false;
+                    for (std::size_t index = 0, previous = _points.size() - 1; index < _points.size();
+                         previous = index++) {
+                        const auto& first = _points[index];
+                        const auto& second = _points[previous];
+                        if ((first.second > y) != (second.second > y)
+                            && x < (second.first - first.first) * (y - first.second) / (second.second - first.second)
+                                       + first.first) {
+                            inside = !inside;
+                        }
+                    }
+                    return inside;
+                }
+            }
+            return false;
+        }
+
+        protected:
+        /// shape lists the supported region shapes.
+        enum class shape { rectangle, disk, polygon };
+
+        region(shape region_shape) : _shape(region_shape) {}
+
+        shape _shape;
+        std::vector<std::pair<float, float>> _points;
+    };
+
+    /// select_regions dispatches the events to the regions they belong to.
+    /// Regions are rasterised at construction into a per-pixel bitmap, so that
+    /// each event costs one lookup regardless of the number of regions.
+    /// Regions can be updated from another thread while events are handled.
+    template <typename Event, typename HandleRegionEvent>
+    class select_regions {
+        public:
+        select_regions(
+            uint16_t width,
+            uint16_t height,
+            std::vector<region> regions,
+            HandleRegionEvent&& handle_region_event) :
+            _width(width),
+            _height(height),
+            _handle_region_event(std::forward<HandleRegionEvent>(handle_region_event)),
+            _regions(std::move(regions)),
+            _lookup(rasterise()),
+            _pending_lookup(nullptr) {}
+        select_regions(const select_regions&) = delete;
+        select_regions(select_regions&& other) :
+            _width(other._width),
+            _height(other._height),
+            _handle_region_event(std::forward<HandleRegionEvent>(other._handle_region_event)),
+            _regions(std::move(other._regions)),
+            _lookup(std::move(other._lookup)),
+            _pending_lookup(other._pending_lookup.exchange(nullptr, std::memory_order_acq_rel)) {}
+        select_regions& operator=(const select_regions&) = delete;
+        select_regions& operator=(select_regions&&) = delete;
+        virtual ~select_regions() {
+            delete _pending_lookup.load(std::memory_order_acquire);
+        }
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            if (_pending_lookup.load(std::memory_order_relaxed) != nullptr) {
+                std::unique_ptr<lookup> pending_lookup(_pending_lookup.exchange(nullptr, std::memory_order_acq_rel));
+                if (pending_lookup) {
+                    _lookup.swap(pending_lookup);
+                }
+            }
+            const auto words = _lookup->words;
+            const auto masks = _lookup->masks.data() + (event.x + event.y * _width) * words;
+            for (std::size_t word = 0; word < words; ++word) {
+                for (auto mask = masks[word]; mask != 0; mask &= mask - 1) {
+                    _handle_region_event(event, word * 64 + trailing_zeros(mask));
+                }
+            }
+        }
+
+        /// update replaces a region.
+        /// It must not be called concurrently with another update or assign, but
+        /// can be called while events are handled on another thread.
+        void update(std::size_t index, region new_region) {
+            _regions.at(index) = std::move(new_region);
+            publish();
+        }
+
+        /// assign replaces all the regions.
+        /// The same threading rules as update apply.
+        void assign(std::vector<region> regions) {
+            _regions = std::move(regions);
+            publish();
+        }
+
+        protected:
+        /// lookup stores a bitmap of regions per pixel.
+        struct lookup {
+            std::size_t words;
+            std::vector<uint64_t> masks;
+        };
+
+        /// trailing_zeros returns the index of the lowest set bit.
+        static std::size_t trailing_zeros(uint64_t mask) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return index;
+#else
+            return __builtin_ctzll(mask);
+#endif
+        }
+
+        /// rasterise builds the lookup of the current regions.
+        std::unique_ptr<lookup> rasterise() const {
+            std::unique_ptr<lookup> result(new lookup);
+            result->words = std::max(static_cast<std::size_t>(1), (_regions.size() + 63) / 64);
+            result->masks.resize(static_cast<std::size_t>(_width) * _height * result->words, 0);
+            for (std::size_t index = 0; index < _regions.size(); ++index) {
+                const auto bounding_box = _regions[index].bounding_box(_width, _height);
+                for (uint32_t y = bounding_box.first.second; y <= bounding_box.second.second; ++y) {
+                    for (uint32_t x = bounding_box.first.first; x <= bounding_box.second.first; ++x) {
+                        if (_regions[index].contains(x, y)) {
+                            result->masks[(x + y * _width) * result->words + index / 64] |=
+                                (static_cast<uint64_t>(1) << (index % 64));
+                        }
+                    }
+                }
+            }
+            return result;
+        }
+
+        /// publish hands a new lookup over to the event handling thread.
+        void publish() {
+            delete _pending_lookup.exchange(rasterise().release(), std::memory_order_acq_rel);
+        }
+
+        const uint16_t _width;
+        const uint16_t _height;
+        HandleRegionEvent _handle_region_event;
+        std::vector<region> _regions;
+        std::unique_ptr<lookup> _lookup;
+        std::atomic<lookup*> _pending_lookup;
+    };
+
+    /// make_select_regions creates a select_regions from a functor.
+    template <typename Event, typename HandleRegionEvent>
+    inline select_regions<Event, HandleRegionEvent> make_select_regions(
+        uint16_t width,
+        uint16_t height,
+        std::vector<region> regions,
+        HandleRegionEvent&& handle_region_event) {
+        return select_regions<Event, HandleRegionEvent>(
+            width, height, std::move(regions), std::forward<HandleRegionEvent>(handle_region_event));
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// shedding lists the subsampling strategies of shed_load.
+    enum class shedding {
+        /// thinning keeps each event with a probability equal to the keep ratio,
+        /// using a deterministic pseudo-random generator.
+        thinning,
+
+        /// stratified keeps a regular fraction of the events of each pixel, so that
+        /// the subsampled stream stays spatially uniform.
+        stratified,
+    };
+
+    /// shed_load subsamples the events when the global event rate exceeds a budget.
+    /// The rate is estimated with an exponential decay, as in compute_activity but
+    /// for the whole sensor. The estimate is updated every update_period, which
+    /// keeps the per-event cost to an increment and a comparison. update_period must be larger than 0, so that
+    /// the elapsed time of an update is never 0.
+    /// maximum_rate is expressed in events per timestamp unit.
+    /// The applied keep ratio is passed to event_to_shed_event, so that downstream
+    /// statistics can be rescaled.
+    template <typename Event, typename ShedEvent, typename EventToShedEvent, typename HandleShedEvent>
+    class shed_load {
+        public:
+        shed_load(
+            uint16_t width,
+            uint16_t height,
+            float maximum_rate,
+            float decay,
+            uint64_t update_period,
+            shedding strategy,
+            EventToShedEvent&& event_to_shed_event,
+            HandleShedEvent&& handle_shed_event) :
+            _width(width),
+            _maximum_rate(maximum_rate),
+            _decay(decay),
+            _update_period(update_period),
+            _strategy(strategy),
+            _event_to_shed_event(std::forward<EventToShedEvent>(event_to_shed_event)),
+            _handle_shed_event(std::forward<HandleShedEvent>(handle_shed_event)),
+            _potential(0.0f),
+            _count(0),
+            _t(0),
+            _ratio(1.0f),
+            _threshold(65536),
+            _state(0x9e3779b9),
+            _credits(strategy == shedding::stratified ? width * height : 0, 0) {
+            if (_maximum_rate <= 0) {
+                throw std::logic_error("maximum_rate must be larger than 0");
+            }
+            if (_decay <= 0) {
+                throw std::logic_error("decay must be larger than 0");
+            }
+            if (_update_period == 0) {
+                throw std::logic_error("update_period must be larger than 0");
+            }
+        }
+        shed_load(const shed_load&) = delete;
+        shed_load(shed_load&&) = default;
+        shed_load& operator=(const shed_load&) = delete;
+        shed_load& operator=(shed_load&&) = default;
+        virtual ~shed_load() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            ++_count;
+            if (event.t >= _t + _update_period) {
+                // the events since the last update are assumed to be uniformly distributed in time
+                const auto delta_t = static_cast<float>(event.t - _t);
+                const auto factor = std::exp(-delta_t / _decay);
+                _potential = _potential * factor + _count * (1.0f - factor) * _decay / delta_t;
+                _count = 0;
+                _t = event.t;
+                const auto rate = _potential / _decay;
+                _ratio = rate > _maximum_rate ? _maximum_rate / rate : 1.0f;
+                _threshold = static_cast<uint32_t>(_ratio * 65536.0f);
+            }
+            if (_ratio >= 1.0f) {
+                _handle_shed_event(_event_to_shed_event(event, 1.0f));
+                return;
+            }
+            switch (_strategy) {
+                case shedding::thinning:
+                    _state ^= _state << 13;
+                    _state ^= _state >> 17;
+                    _state ^= _state << 5;
+                    if ((_state >> 16) < _threshold) {
+                        _handle_shed_event(_event_to_shed_event(event, _ratio));
+                    }
+                    break;
+                case shedding::stratified: {
+                    auto& credit = _credits[event.x + event.y * _width];
+                    credit += _threshold;
+                    if (credit >= 65536) {
+                        credit -= 65536;
+                        _handle_shed_event(_event_to_shed_event(event, _ratio));
+                    }
+                    break;
+                }
+            }
+        }
+
+        /// ratio returns the current keep ratio, in the range ]0, 1].
+        float ratio() const {
+            return _ratio;
+        }
+
+        protected:
+        const uint16_t _width;
+        const float _maximum_rate;
+        const float _decay;
+        const uint64_t _update_period;
+        const shedding _strategy;
+        EventToShedEvent _event_to_shed_event;
+        HandleShedEvent _handle_shed_event;
+        float _potential;
+        uint32_t _count;
+        uint64_t _t;
+        float _ratio;
+        uint32_t _threshold;
+        uint32_t _state;
+        std::vector<uint32_t> _credits;
+    };
+
+    /// make_shed_load creates a shed_load from functors.
+    template <typename Event, typename ShedEvent, typename EventToShedEvent, typename HandleShedEvent>
+    inline shed_load<Event, ShedEvent, EventToShedEvent, HandleShedEvent> make_shed_load(
+        uint16_t width,
+        uint16_t height,
+        float maximum_rate,
+        float decay,
+        uint64_t update_period,
+        shedding strategy,
+        EventToShedEvent&& event_to_shed_event,
+        HandleShedEvent&& handle_shed_event) {
+        return shed_load<Event, ShedEvent, EventToShedEvent, HandleShedEvent>(
+            width,
+            height,
+            maximum_rate,
+            decay,
+            update_period,
+            strategy,
+            std::forward<EventToShedEvent>(event_to_shed_event),
+            std::forward<HandleShedEvent>(handle_shed_event));
+    }
+}
@@ -40,4 +40,34 @@ namespace tarsier {
     inline shift_x<Event, HandleEvent> make_shift_x(uint16_t width, int32_t shift, HandleEvent&& handle_event) {
         return shift_x<Event, HandleEvent>(width, shift, std::forward<HandleEvent>(handle_event));
     }
+
+    /// static_shift_x translates the x coordinate, with the width and shift known at compile time.
+    template <typename Event, uint16_t width, int32_t shift, typename HandleEvent>
+    class static_shift_x {
+        public:
+        static_shift_x(HandleEvent&& handle_event) : _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        static_shift_x(const static_shift_x&) = delete;
+        static_shift_x(static_shift_x&&) = default;
+        static_shift_x& operator=(const static_shift_x&) = delete;
+        static_shift_x& operator=(static_shift_x&&) = default;
+        virtual ~static_shift_x() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto shifted = static_cast<int32_t>(event.x) + shift;
+            if (shifted >= 0 && shifted < width) {
+                event.x = shifted;
+                _handle_event(event);
+            }
+        }
+
+        protected:
+        HandleEvent _handle_event;
+    };
+
+    /// make_shift_x creates a static_shift_x from a functor.
+    template <typename Event, uint16_t width, int32_t shift, typename HandleEvent>
+    inline static_shift_x<Event, width, shift, HandleEvent> make_shift_x(HandleEvent&& handle_event) {
+        return static_shift_x<Event, width, shift, HandleEvent>(std::forward<HandleEvent>(handle_event));
+    }
 }
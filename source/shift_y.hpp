@@ -40,4 +40,34 @@ namespace tarsier {
     inline shift_y<Event, HandleEvent> make_shift_y(uint16_t height, int32_t shift, HandleEvent&& handle_event) {
         return shift_y<Event, HandleEvent>(height, shift, std::forward<HandleEvent>(handle_event));
     }
+
+    /// static_shift_y translates the y coordinate, with the height and shift known at compile time.
+    template <typename Event, uint16_t height, int32_t shift, typename HandleEvent>
+    class static_shift_y {
+        public:
+        static_shift_y(HandleEvent&& handle_event) : _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        static_shift_y(const static_shift_y&) = delete;
+        static_shift_y(static_shift_y&&) = default;
+        static_shift_y& operator=(const static_shift_y&) = delete;
+        static_shift_y& operator=(static_shift_y&&) = default;
+        virtual ~static_shift_y() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto shifted = static_cast<int32_t>(event.y) + shift;
+            if (shifted >= 0 && shifted < height) {
+                event.y = shifted;
+                _handle_event(event);
+            }
+        }
+
+        protected:
+        HandleEvent _handle_event;
+    };
+
+    /// make_shift_y creates a static_shift_y from a functor.
+    template <typename Event, uint16_t height, int32_t shift, typename HandleEvent>
+    inline static_shift_y<Event, height, shift, HandleEvent> make_shift_y(HandleEvent&& handle_event) {
+        return static_shift_y<Event, height, shift, HandleEvent>(std::forward<HandleEvent>(handle_event));
+    }
 }
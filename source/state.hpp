@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// state_format describes the binary layout of handler states, written by save_state and read by load_state.
+    /// A state starts with a signature, a version and the handler's name, followed by the handler's values
+    /// and buffers. Each buffer is stored as its element size, its number of elements and its raw bytes.
+    /// Every item is padded to a multiple of 8 bytes, so that a memory-mapped state can be used in place.
+    /// Values are stored in native byte order, hence a state is only valid on the architecture that saved it.
+    /// Buffers of structures with padding bytes are stored field by field.
+    namespace state_format {
+        /// signature is the first 8 bytes of a state.
+        const std::array<char, 8> signature{{'T', 'A', 'R', 'S', 'I', 'E', 'R', 'S'}};
+
+        /// version is the format version.
+        const uint8_t version = 1;
+
+        /// write_padding pads an item of the given size to a multiple of 8 bytes.
+        inline void write_padding(std::ostream& stream, std::size_t size) {
+            const std::array<char, 8> zeros{};
+            stream.write(zeros.data(), static_cast<std::streamsize>((8 - size % 8) % 8));
+        }
+
+        /// read_bytes loads bytes and skips the padding.
+        inline void read_bytes(std::istream& stream, char* bytes, std::size_t size) {
+            stream.read(bytes, static_cast<std::streamsize>(size));
+            stream.ignore(static_cast<std::streamsize>((8 - size % 8) % 8));
+            if (!stream) {
+                throw std::runtime_error("the state is truncated");
+            }
+        }
+
+        /// write_header stores the signature, the version and the handler's name.
+        inline void write_header(std::ostream& stream, const std::string& name) {
+            stream.write(signature.data(), signature.size());
+            const std::array<char, 8> version_and_size{{
+                static_cast<char>(version),
+                0,
+                0,
+                0,
+                static_cast<char>(name.size() & 0xff),
+                static_cast<char>((name.size() >> 8) & 0xff),
+                0,
+                0,
+            }};
+            stream.write(version_and_size.data(), version_and_size.size());
+            stream.write(name.data(), static_cast<std::streamsize>(name.size()));
+            write_padding(stream, name.size());
+        }
+
+        /// read_header checks the signature, the version and the handler's name.
+        inline void read_header(std::istream& stream, const std::string& name) {
+            std::array<char, 16> bytes;
+            read_bytes(stream, bytes.data(), bytes.size());
+            if (!std::equal(signature.begin(), signature.end(), bytes.begin())) {
+                throw std::runtime_error("the stream is not a state");
+            }
+            if (static_cast<uint8_t>(bytes[8]) != version) {
+                throw std::runtime_error("the state has an unsupported version");
+            }
+            std::string state_name(
+                static_cast<uint8_t>(bytes[12]) | (static_cast<std::size_t>(static_cast<uint8_t>(bytes[13])) << 8),
+                '\0');
+            read_bytes(stream, &state_name[0], state_name.size());
+            if (state_name != name) {
+                throw std::runtime_error(std::string("the state was saved by ") + state_name + ", not " + name);
+            }
+        }
+
+        /// write_value stores a trivially copyable value.
+        template <typename Value>
+        inline void write_value(std::ostream& stream, const Value& value) {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(Value));
+            write_padding(stream, sizeof(Value));
+        }
+
+        /// read_value loads a trivially copyable value.
+        template <typename Value>
+        inline void read_value(std::istream& stream, Value& value) {
+            read_bytes(stream, reinterpret_cast<char*>(&value), sizeof(Value));
+        }
+
+        /// write_buffer stores a vector of trivially copyable elements in bulk.
+        template <typename Element>
+        inline void write_buffer(std::ostream& stream, const std::vector<Element>& buffer) {
+            write_value(stream, static_cast<uint64_t>(sizeof(Element)));
+            write_value(stream, static_cast<uint64_t>(buffer.size()));
+            stream.write(
+                reinterpret_cast<const char*>(buffer.data()),
+                static_cast<std::streamsize>(buffer.size() * sizeof(Element)));
+            write_padding(stream, buffer.size() * sizeof(Element));
+        }
+
+        /// read_buffer loads a vector of trivially copyable elements in bulk.
+        /// The buffer must have the size of the saved one, since it depends on the handler's parameters.
+        template <typename Element>
+        inline void read_buffer(std::istream& stream, std::vector<Element>& buffer) {
+            uint64_t element_size;
+            read_value(stream, element_size);
+            uint64_t size;
+            read_value(stream, size);
+            if (element_size != sizeof(Element) || size != buffer.size()) {
+                throw std::runtime_error("the state's buffer does not match the handler's parameters");
+            }
+            read_bytes(stream, reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(Element));
+        }
+
+        /// field_type is the type used to store a field, since std::vector<bool> has no contiguous storage.
+        template <typename Field>
+        using field_type = typename std::conditional<std::is_same<Field, bool>::value, uint8_t, Field>::type;
+
+        /// write_field stores one field of each element of a vector, as a buffer.
+        /// Structures with padding bytes must be written field by field, since their padding is not initialised.
+        template <typename Element, typename Field>
+        inline void write_field(std::ostream& stream, const std::vector<Element>& buffer, Field Element::*field) {
+            std::vector<field_type<Field>> values(buffer.size());
+            for (std::size_t index = 0; index < buffer.size(); ++index) {
+                values[index] = buffer[index].*field;
+            }
+            write_buffer(stream, values);
+        }
+
+        /// read_field loads one field of each element of a vector, written by write_field.
+        template <typename Element, typename Field>
+        inline void read_field(std::istream& stream, std::vector<Element>& buffer, Field Element::*field) {
+            std::vector<field_type<Field>> values(buffer.size());
+            read_buffer(stream, values);
+            for (std::size_t index = 0; index < buffer.size(); ++index) {
+                buffer[index].*field = static_cast<Field>(values[index]);
+            }
+        }
+    }
+}
@@ -1,12 +1,39 @@
 #pragma once
 
+#include "state.hpp"
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
 
+    /// stitch_pixel updates a pixel's state with a threshold crossing, and returns true if the crossing completes
+    /// an exposure measurement, in which case the measurement's duration is written to delta_t.
+    /// The state packs the triggered flag in its most significant bit, and the 31 least significant bits of the
+    /// first crossing's timestamp in the others. Hence the exposure durations must be smaller than 2^31.
+    template <typename ThresholdCrossing>
+    inline bool stitch_pixel(uint32_t& state, ThresholdCrossing threshold_crossing, uint64_t& delta_t) {
+        const uint32_t triggered = 0x80000000u;
+        const auto t = static_cast<uint32_t>(threshold_crossing.t) & ~triggered;
+        if ((state & triggered) == 0) {
+            if (!threshold_crossing.is_second) {
+                state = triggered | t;
+            }
+            return false;
+        }
+        if (threshold_crossing.is_second) {
+            delta_t = (t - state) & ~triggered;
+            state &= ~triggered;
+            return true;
+        }
+        state = triggered | t;
+        return false;
+    }
+
     /// stitch turns a stream of threshold crossings into a stream of time deltas.
     template <typename ThresholdCrossing, typename Event, typename ThresholdCrossingToEvent, typename HandleEvent>
     class stitch {
@@ -20,7 +47,7 @@ namespace tarsier {
             _height(height),
             _threshold_crossing_to_event(std::forward<ThresholdCrossingToEvent>(threshold_crossing_to_event)),
             _handle_event(std::forward<HandleEvent>(handle_event)),
-            _are_triggered_and_ts(width * height, {false, 0}) {}
+            _states(width * height, 0) {}
         stitch(const stitch&) = delete;
         stitch(stitch&&) = default;
         stitch& operator=(const stitch&) = delete;
@@ -29,29 +56,32 @@ namespace tarsier {
 
         /// operator() handles a threshold crossing.
         virtual void operator()(ThresholdCrossing threshold_crossing) {
-            auto& is_triggered_and_t = _are_triggered_and_ts[threshold_crossing.x + threshold_crossing.y * _width];
-            if (!is_triggered_and_t.first) {
-                if (!threshold_crossing.is_second) {
-                    is_triggered_and_t.first = true;
-                    is_triggered_and_t.second = threshold_crossing.t;
-                }
-            } else {
-                if (threshold_crossing.is_second) {
-                    is_triggered_and_t.first = false;
-                    _handle_event(_threshold_crossing_to_event(
-                        threshold_crossing, threshold_crossing.t - is_triggered_and_t.second));
-                } else {
-                    is_triggered_and_t.second = threshold_crossing.t;
-                }
+            uint64_t delta_t;
+            if (stitch_pixel(
+                    _states[threshold_crossing.x + threshold_crossing.y * _width], threshold_crossing, delta_t)) {
+                _handle_event(_threshold_crossing_to_event(threshold_crossing, delta_t));
             }
         }
 
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "stitch");
+            state_format::write_buffer(stream, _states);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "stitch");
+            state_format::read_buffer(stream, _states);
+        }
+
         protected:
         const uint16_t _width;
         const uint16_t _height;
         ThresholdCrossingToEvent _threshold_crossing_to_event;
         HandleEvent _handle_event;
-        std::vector<std::pair<bool, uint64_t>> _are_triggered_and_ts;
+        std::vector<uint32_t> _states;
     };
 
     /// make_stitch creates a stitch from functors.
@@ -67,4 +97,97 @@ namespace tarsier {
             std::forward<ThresholdCrossingToEvent>(threshold_crossing_to_event),
             std::forward<HandleEvent>(handle_event));
     }
+
+    /// stitch_frame turns a stream of threshold crossings into a stream of greyscale frames.
+    /// Each completed exposure measurement is converted to a grey level, written to its pixel in the current frame.
+    /// The frame is passed to handle_frame once per frame_period, before the first threshold crossing whose
+    /// timestamp reaches the end of the period. A pixel keeps its grey level until its next measurement.
+    /// The frames are double-buffered: the frame passed to handle_frame is left unchanged until the next call.
+    template <typename ThresholdCrossing, typename Grey, typename ThresholdCrossingToGrey, typename HandleFrame>
+    class stitch_frame {
+        public:
+        stitch_frame(
+            uint16_t width,
+            uint16_t height,
+            uint64_t frame_period,
+            ThresholdCrossingToGrey&& threshold_crossing_to_grey,
+            HandleFrame&& handle_frame) :
+            _width(width),
+            _height(height),
+            _frame_period(frame_period),
+            _threshold_crossing_to_grey(std::forward<ThresholdCrossingToGrey>(threshold_crossing_to_grey)),
+            _handle_frame(std::forward<HandleFrame>(handle_frame)),
+            _states(width * height, 0),
+            _frames{{std::vector<Grey>(width * height, Grey{}), std::vector<Grey>(width * height, Grey{})}},
+            _active(0),
+            _next_frame_t(frame_period) {
+            if (_frame_period == 0) {
+                throw std::logic_error("frame_period must be larger than 0");
+            }
+        }
+        stitch_frame(const stitch_frame&) = delete;
+        stitch_frame(stitch_frame&&) = default;
+        stitch_frame& operator=(const stitch_frame&) = delete;
+        stitch_frame& operator=(stitch_frame&&) = default;
+        virtual ~stitch_frame() = default;
+
+        /// operator() handles a threshold crossing.
+        virtual void operator()(ThresholdCrossing threshold_crossing) {
+            if (threshold_crossing.t >= _next_frame_t) {
+                _next_frame_t = threshold_crossing.t + _frame_period;
+                _handle_frame(static_cast<const std::vector<Grey>&>(_frames[_active]));
+                std::copy(_frames[_active].begin(), _frames[_active].end(), _frames[1 - _active].begin());
+                _active = 1 - _active;
+            }
+            const auto index = threshold_crossing.x + threshold_crossing.y * _width;
+            uint64_t delta_t;
+            if (stitch_pixel(_states[index], threshold_crossing, delta_t)) {
+                _frames[_active][index] = _threshold_crossing_to_grey(threshold_crossing, delta_t);
+            }
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "stitch_frame");
+            state_format::write_buffer(stream, _states);
+            state_format::write_buffer(stream, _frames[_active]);
+            state_format::write_value(stream, _next_frame_t);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "stitch_frame");
+            state_format::read_buffer(stream, _states);
+            state_format::read_buffer(stream, _frames[_active]);
+            state_format::read_value(stream, _next_frame_t);
+        }
+
+        protected:
+        const uint16_t _width;
+        const uint16_t _height;
+        const uint64_t _frame_period;
+        ThresholdCrossingToGrey _threshold_crossing_to_grey;
+        HandleFrame _handle_frame;
+        std::vector<uint32_t> _states;
+        std::array<std::vector<Grey>, 2> _frames;
+        std::size_t _active;
+        uint64_t _next_frame_t;
+    };
+
+    /// make_stitch_frame creates a stitch_frame from functors.
+    template <typename ThresholdCrossing, typename Grey, typename ThresholdCrossingToGrey, typename HandleFrame>
+    inline stitch_frame<ThresholdCrossing, Grey, ThresholdCrossingToGrey, HandleFrame> make_stitch_frame(
+        uint16_t width,
+        uint16_t height,
+        uint64_t frame_period,
+        ThresholdCrossingToGrey&& threshold_crossing_to_grey,
+        HandleFrame&& handle_frame) {
+        return stitch_frame<ThresholdCrossing, Grey, ThresholdCrossingToGrey, HandleFrame>(
+            width,
+            height,
+            frame_period,
+            std::forward<ThresholdCrossingToGrey>(threshold_crossing_to_grey),
+            std::forward<HandleFrame>(handle_frame));
+    }
 }
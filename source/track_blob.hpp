@@ -1,6 +1,8 @@
 #pragma once
 
+#include "state.hpp"
 #include <cmath>
+#include <cstdint>
 #include <stdexcept>
 #include <utility>
 
@@ -79,6 +81,27 @@ namespace tarsier {
             return _sigma_y_squared;
         }
 
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "track_blob");
+            state_format::write_value(stream, _x);
+            state_format::write_value(stream, _y);
+            state_format::write_value(stream, _sigma_x_squared);
+            state_format::write_value(stream, _sigma_xy);
+            state_format::write_value(stream, _sigma_y_squared);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "track_blob");
+            state_format::read_value(stream, _x);
+            state_format::read_value(stream, _y);
+            state_format::read_value(stream, _sigma_x_squared);
+            state_format::read_value(stream, _sigma_xy);
+            state_format::read_value(stream, _sigma_y_squared);
+        }
+
         protected:
         float _x;
         float _y;
@@ -114,4 +137,158 @@ namespace tarsier {
             std::forward<EventToBlob>(event_to_blob),
             std::forward<HandleBlob>(handle_blob));
     }
+
+    /// temporal_track_blob averages the incoming events with a gaussian blob.
+    /// An exponential time-wise decay is used as weight: the previous moments are weighted by
+    /// exp(-delta_t / position_decay) and exp(-delta_t / variance_decay), where delta_t is the time elapsed
+    /// since the previous event, hence the time constants do not depend on the event rate.
+    /// If output_period is not 0, the blob is passed at most once per period.
+    template <typename Event, typename Blob, typename EventToBlob, typename HandleBlob>
+    class temporal_track_blob {
+        public:
+        temporal_track_blob(
+            float x,
+            float y,
+            float sigma_x_squared,
+            float sigma_xy,
+            float sigma_y_squared,
+            float position_decay,
+            float variance_decay,
+            uint64_t output_period,
+            EventToBlob&& event_to_blob,
+            HandleBlob&& handle_blob) :
+            _x(x),
+            _y(y),
+            _sigma_x_squared(sigma_x_squared),
+            _sigma_xy(sigma_xy),
+            _sigma_y_squared(sigma_y_squared),
+            _position_decay(position_decay),
+            _variance_decay(variance_decay),
+            _output_period(output_period),
+            _event_to_blob(std::forward<EventToBlob>(event_to_blob)),
+            _handle_blob(std::forward<HandleBlob>(handle_blob)),
+            _previous_t(0),
+            _next_output_t(0) {
+            if (!(_position_decay > 0)) {
+                throw std::logic_error("position_decay must be larger than 0");
+            }
+            if (!(_variance_decay > 0)) {
+                throw std::logic_error("variance_decay must be larger than 0");
+            }
+        }
+        temporal_track_blob(const temporal_track_blob&) = delete;
+        temporal_track_blob(temporal_track_blob&&) = default;
+        temporal_track_blob& operator=(const temporal_track_blob&) = delete;
+        temporal_track_blob& operator=(temporal_track_blob&&) = default;
+        virtual ~temporal_track_blob() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            const auto delta_t = static_cast<float>(event.t - _previous_t);
+            _previous_t = event.t;
+            const auto position_inertia = std::exp(-delta_t / _position_decay);
+            const auto variance_inertia = std::exp(-delta_t / _variance_decay);
+            const auto x_delta = event.x - _x;
+            const auto y_delta = event.y - _y;
+            _x = position_inertia * _x + (1 - position_inertia) * event.x;
+            _y = position_inertia * _y + (1 - position_inertia) * event.y;
+            _sigma_x_squared = variance_inertia * _sigma_x_squared + (1 - variance_inertia) * x_delta * x_delta;
+            _sigma_xy = variance_inertia * _sigma_xy + (1 - variance_inertia) * x_delta * y_delta;
+            _sigma_y_squared = variance_inertia * _sigma_y_squared + (1 - variance_inertia) * y_delta * y_delta;
+            if (event.t >= _next_output_t) {
+                _next_output_t = event.t + _output_period;
+                _handle_blob(_event_to_blob(event, _x, _y, _sigma_x_squared, _sigma_xy, _sigma_y_squared));
+            }
+        }
+
+        /// x returns the blob's center's x coordinate.
+        float x() const {
+            return _x;
+        }
+
+        /// y returns the blob's center's y coordinate.
+        float y() const {
+            return _y;
+        }
+
+        /// sigma_x_squared returns the blob's variance along the x axis.
+        float sigma_x_squared() const {
+            return _sigma_x_squared;
+        }
+
+        /// sigma_xy returns the blob's covariance.
+        float sigma_xy() const {
+            return _sigma_xy;
+        }
+
+        /// sigma_y_squared returns the blob's variance along the y axis.
+        float sigma_y_squared() const {
+            return _sigma_y_squared;
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "temporal_track_blob");
+            state_format::write_value(stream, _x);
+            state_format::write_value(stream, _y);
+            state_format::write_value(stream, _sigma_x_squared);
+            state_format::write_value(stream, _sigma_xy);
+            state_format::write_value(stream, _sigma_y_squared);
+            state_format::write_value(stream, _previous_t);
+            state_format::write_value(stream, _next_output_t);
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "temporal_track_blob");
+            state_format::read_value(stream, _x);
+            state_format::read_value(stream, _y);
+            state_format::read_value(stream, _sigma_x_squared);
+            state_format::read_value(stream, _sigma_xy);
+            state_format::read_value(stream, _sigma_y_squared);
+            state_format::read_value(stream, _previous_t);
+            state_format::read_value(stream, _next_output_t);
+        }
+
+        protected:
+        float _x;
+        float _y;
+        float _sigma_x_squared;
+        float _sigma_xy;
+        float _sigma_y_squared;
+        const float _position_decay;
+        const float _variance_decay;
+        const uint64_t _output_period;
+        EventToBlob _event_to_blob;
+        HandleBlob _handle_blob;
+        uint64_t _previous_t;
+        uint64_t _next_output_t;
+    };
+
+    /// make_temporal_track_blob creates a temporal_track_blob from functors.
+    template <typename Event, typename Blob, typename EventToBlob, typename HandleBlob>
+    inline temporal_track_blob<Event, Blob, EventToBlob, HandleBlob> make_temporal_track_blob(
+        float x,
+        float y,
+        float sigma_x_squared,
+        float sigma_xy,
+        float sigma_y_squared,
+        float position_decay,
+        float variance_decay,
+        uint64_t output_period,
+        EventToBlob&& event_to_blob,
+        HandleBlob&& handle_blob) {
+        return temporal_track_blob<Event, Blob, EventToBlob, HandleBlob>(
+            x,
+            y,
+            sigma_x_squared,
+            sigma_xy,
+            sigma_y_squared,
+            position_decay,
+            variance_decay,
+            output_period,
+            std::forward<EventToBlob>(event_to_blob),
+            std::forward<HandleBlob>(handle_blob));
+    }
 }
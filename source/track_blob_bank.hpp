@@ -0,0 +1,242 @@
+#pragma once
+
+#include "state.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// gated_blob describes a blob of a track_blob_bank: the disk gating its events, and its initial moments.
+    struct gated_blob {
+        float gate_x;
+        float gate_y;
+        float gate_radius;
+        float x;
+        float y;
+        float sigma_x_squared;
+        float sigma_xy;
+        float sigma_y_squared;
+    };
+
+    /// track_blob_bank averages the incoming events with a bank of independent gaussian blobs.
+    /// Each blob behaves as a track_blob behind a select_disk: it is updated by the events within its gate disk,
+    /// with the same inertias.
+    /// The gates and the moments are stored as contiguous arrays, each one starting on a 64 bytes boundary,
+    /// and every event is tested against all the gates with a branchless loop that the compiler vectorizes.
+    /// event_to_blob is called for each updated blob, with the event, the blob's id and its moments.
+    template <typename Event, typename Blob, typename EventToBlob, typename HandleBlob>
+    class track_blob_bank {
+        public:
+        /// arrays is the number of arrays in the storage.
+        static constexpr std::size_t arrays = 9;
+
+        track_blob_bank(
+            const std::vector<gated_blob>& blobs,
+            float position_inertia,
+            float variance_inertia,
+            EventToBlob&& event_to_blob,
+            HandleBlob&& handle_blob) :
+            _size(blobs.size()),
+            _stride((blobs.size() + 15) / 16 * 16),
+            _position_inertia(position_inertia),
+            _variance_inertia(variance_inertia),
+            _event_to_blob(std::forward<EventToBlob>(event_to_blob)),
+            _handle_blob(std::forward<HandleBlob>(handle_blob)),
+            _storage(_stride * arrays + 15, 0.0f) {
+            if (_position_inertia < 0 || _position_inertia > 1) {
+                throw std::logic_error("position_inertia must be in the range [0, 1]");
+            }
+            if (_variance_inertia < 0 || _variance_inertia > 1) {
+                throw std::logic_error("variance_inertia must be in the range [0, 1]");
+            }
+            _offset = static_cast<std::size_t>(
+                (64 - reinterpret_cast<std::uintptr_t>(_storage.data()) % 64) % 64 / sizeof(float));
+            for (std::size_t id = 0; id < _size; ++id) {
+                array(gate_x_array)[id] = blobs[id].gate_x;
+                array(gate_y_array)[id] = blobs[id].gate_y;
+                array(squared_radius_array)[id] = blobs[id].gate_radius * blobs[id].gate_radius;
+                array(x_array)[id] = blobs[id].x;
+                array(y_array)[id] = blobs[id].y;
+                array(sigma_x_squared_array)[id] = blobs[id].sigma_x_squared;
+                array(sigma_xy_array)[id] = blobs[id].sigma_xy;
+                array(sigma_y_squared_array)[id] = blobs[id].sigma_y_squared;
+            }
+        }
+        track_blob_bank(const track_blob_bank&) = delete;
+        track_blob_bank(track_blob_bank&&) = default;
+        track_blob_bank& operator=(const track_blob_bank&) = delete;
+        track_blob_bank& operator=(track_blob_bank&&) = default;
+        virtual ~track_blob_bank() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            update(event);
+        }
+
+        /// operator() handles a batch of events, for instance a block of a read_stream.
+        void operator()(const Event* begin, const Event* end) {
+            for (; begin != end; ++begin) {
+                update(*begin);
+            }
+        }
+
+        /// size returns the number of blobs.
+        std::size_t size() const {
+            return _size;
+        }
+
+        /// x returns the x coordinate of the given blob's center.
+        float x(std::size_t id) const {
+            return array(x_array)[id];
+        }
+
+        /// y returns the y coordinate of the given blob's center.
+        float y(std::size_t id) const {
+            return array(y_array)[id];
+        }
+
+        /// sigma_x_squared returns the given blob's variance along the x axis.
+        float sigma_x_squared(std::size_t id) const {
+            return array(sigma_x_squared_array)[id];
+        }
+
+        /// sigma_xy returns the given blob's covariance.
+        float sigma_xy(std::size_t id) const {
+            return array(sigma_xy_array)[id];
+        }
+
+        /// sigma_y_squared returns the given blob's variance along the y axis.
+        float sigma_y_squared(std::size_t id) const {
+            return array(sigma_y_squared_array)[id];
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "track_blob_bank");
+            state_format::write_buffer(
+                stream, std::vector<float>(array(x_array), array(x_array) + (arrays - x_array) * _stride));
+        }
+
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "track_blob_bank");
+            std::vector<float> moments((arrays - x_array) * _stride);
+            state_format::read_buffer(stream, moments);
+            std::copy(moments.begin(), moments.end(), array(x_array));
+        }
+
+        protected:
+        /// array_index lists the arrays of the storage.
+        enum array_index : std::size_t {
+            gate_x_array,
+            gate_y_array,
+            squared_radius_array,
+            gated_array,
+            x_array,
+            y_array,
+            sigma_x_squared_array,
+            sigma_xy_array,
+            sigma_y_squared_array,
+        };
+
+        /// array returns the first element of an array of the storage.
+        float* array(array_index index) {
+            return _storage.data() + _offset + index * _stride;
+        }
+        const float* array(array_index index) const {
+            return _storage.data() + _offset + index * _stride;
+        }
+
+        /// update applies an event to every blob whose gate contains it, and passes the updated blobs.
+        /// The gates are evaluated for the whole bank by a vectorized loop, and only the gated blobs are updated.
+        void update(Event event) {
+            const auto event_x = static_cast<float>(event.x);
+            const auto event_y = static_cast<float>(event.y);
+            gate(
+                _stride,
+                event_x,
+                event_y,
+                array(gate_x_array),
+                array(gate_y_array),
+                array(squared_radius_array),
+                array(gated_array));
+            const auto gated = array(gated_array);
+            const auto x = array(x_array);
+            const auto y = array(y_array);
+            const auto sigma_x_squared = array(sigma_x_squared_array);
+            const auto sigma_xy = array(sigma_xy_array);
+            const auto sigma_y_squared = array(sigma_y_squared_array);
+            for (std::size_t id = 0; id < _size; ++id) {
+                if (gated[id] != 0.0f) {
+                    const auto x_delta = event_x - x[id];
+                    const auto y_delta = event_y - y[id];
+                    x[id] = _position_inertia * x[id] + (1 - _position_inertia) * event_x;
+                    y[id] = _position_inertia * y[id] + (1 - _position_inertia) * event_y;
+                    sigma_x_squared[id] =
+                        _variance_inertia * sigma_x_squared[id] + (1 - _variance_inertia) * x_delta * x_delta;
+                    sigma_xy[id] = _variance_inertia * sigma_xy[id] + (1 - _variance_inertia) * x_delta * y_delta;
+                    sigma_y_squared[id] =
+                        _variance_inertia * sigma_y_squared[id] + (1 - _variance_inertia) * y_delta * y_delta;
+                    _handle_blob(_event_to_blob(
+                        event, id, x[id], y[id], sigma_x_squared[id], sigma_xy[id], sigma_y_squared[id]));
+                }
+            }
+        }
+
+        /// gate sets gated to 1 for the blobs whose gate contains the event, and to 0 for the others.
+        /// The restrict qualifiers declare the arrays independent, and the loop runs over blocks of 16 floats,
+        /// so that the compiler vectorizes it without alias checks nor remainder.
+        /// The mask is the sign bit of the difference between the squared distance and the squared radius,
+        /// since compilers do not if-convert float comparisons that may trap.
+        static void gate(
+            std::size_t stride,
+            float event_x,
+            float event_y,
+            const float* __restrict gate_x,
+            const float* __restrict gate_y,
+            const float* __restrict squared_radius,
+            float* __restrict gated) {
+            for (std::size_t block = 0; block < stride; block += 16) {
+                for (std::size_t id = block; id < block + 16; ++id) {
+                    const auto x_delta = event_x - gate_x[id];
+                    const auto y_delta = event_y - gate_y[id];
+                    const auto difference = x_delta * x_delta + y_delta * y_delta - squared_radius[id];
+                    uint32_t bits;
+                    std::memcpy(&bits, &difference, sizeof(bits));
+                    gated[id] = static_cast<float>(bits >> 31);
+                }
+            }
+        }
+
+        const std::size_t _size;
+        const std::size_t _stride;
+        const float _position_inertia;
+        const float _variance_inertia;
+        EventToBlob _event_to_blob;
+        HandleBlob _handle_blob;
+        std::vector<float> _storage;
+        std::size_t _offset;
+    };
+
+    /// make_track_blob_bank creates a track_blob_bank from functors.
+    template <typename Event, typename Blob, typename EventToBlob, typename HandleBlob>
+    inline track_blob_bank<Event, Blob, EventToBlob, HandleBlob> make_track_blob_bank(
+        const std::vector<gated_blob>& blobs,
+        float position_inertia,
+        float variance_inertia,
+        EventToBlob&& event_to_blob,
+        HandleBlob&& handle_blob) {
+        return track_blob_bank<Event, Blob, EventToBlob, HandleBlob>(
+            blobs,
+            position_inertia,
+            variance_inertia,
+            std::forward<EventToBlob>(event_to_blob),
+            std::forward<HandleBlob>(handle_blob));
+    }
+}
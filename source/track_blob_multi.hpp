@@ -1,13 +1,75 @@
 #pragma once
 
+#include "state.hpp"
 #include <cmath>
+#include <cstdint>
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
-    /// track_blob_multi averages the incoming events with a gaussian blob.
+
+    /// blob_status describes the change passed to track_blob_multi's callback.
+    enum class blob_status {
+        /// spawn signals a new blob.
+        spawn,
+
+        /// update signals a blob whose state changed, because it was assigned an event or absorbed another blob.
+        update,
+
+        /// kill signals a removed blob, inactive or absorbed by another blob. The state is the blob's last state.
+        kill,
+
+        /// snapshot signals a living blob, passed during a periodic snapshot.
+        snapshot,
+    };
+
+    /// blob_lifecycle configures the creation and the deletion of blobs by track_blob_multi.
+    /// Setting activity_decay, spawn_events or merge_distance to 0 disables respectively the removal,
+    /// the spawning and the merging of blobs.
+    struct blob_lifecycle {
+        /// capacity is the number of blob slots, allocated once by the constructor.
+        uint16_t capacity;
+
+        /// activity_decay is the time constant of the blobs' activity, in timestamp units.
+        /// A blob's activity is increased by one for each event it is assigned, and decays exponentially.
+        float activity_decay;
+
+        /// kill_activity is the activity below which a blob is removed.
+        float kill_activity;
+
+        /// spawn_events is the number of unassigned events that creates a blob, when they are close enough
+        /// in space and time. The last 4 * spawn_events unassigned events are kept.
+        uint16_t spawn_events;
+
+        /// spawn_radius is the maximum distance between an unassigned event and the events it spawns a blob with.
+        float spawn_radius;
+
+        /// spawn_window is the maximum age of the unassigned events that spawn a blob.
+        uint64_t spawn_window;
+
+        /// spawn_variance is added to the variances of the spawning events to initialize a blob.
+        float spawn_variance;
+
+        /// merge_distance is the distance below which the centers of two blobs are merged.
+        float merge_distance;
+    };
+
+    /// track_blob_multi averages the incoming events with several gaussian blobs.
+    /// MultiBlobs must have an id and a vector of blobs, used as a pool of blob slots.
+    /// event_to_blob is called with the event, the id, the status and a reference to the state of each blob that
+    /// changes, hence the cost of the output does not depend on the number of blobs.
+    /// If snapshot_period is not 0, every living blob is also passed with blob_status::snapshot once per period.
+    /// Each event is assigned to the most probable living blob, if its probability is larger than prob_threshold.
+    /// With a lifecycle, blobs whose activity falls below a threshold are removed, clusters of unassigned events
+    /// spawn blobs in free slots, and blobs with close centers are merged. Slots that are not alive keep their last
+    /// state and are ignored. The initial blobs start with an activity equal to spawn_events, or 1 if spawning
+    /// is disabled.
+    /// Events without a t field can be tracked without a lifecycle and without snapshots, since the timestamps are
+    /// only used to decay the activities and to schedule the snapshots.
     template <typename Event, typename MultiBlobs, typename EventToBlob, typename HandleBlob>
     class track_blob_multi {
         public:
@@ -18,12 +80,39 @@ namespace tarsier {
             float variance_inertia,
             EventToBlob&& event_to_blob,
             HandleBlob&& handle_blob) :
+            track_blob_multi(
+                multi_blobs,
+                prob_threshold,
+                position_inertia,
+                variance_inertia,
+                blob_lifecycle{static_cast<uint16_t>(multi_blobs.blobs.size()), 0, 0, 0, 0, 0, 0, 0},
+                0,
+                std::forward<EventToBlob>(event_to_blob),
+                std::forward<HandleBlob>(handle_blob)) {}
+        track_blob_multi(
+            MultiBlobs multi_blobs,
+            float prob_threshold,
+            float position_inertia,
+            float variance_inertia,
+            blob_lifecycle lifecycle,
+            uint64_t snapshot_period,
+            EventToBlob&& event_to_blob,
+            HandleBlob&& handle_blob) :
             _multi_blobs(multi_blobs),
             _prob_threshold(prob_threshold),
             _position_inertia(position_inertia),
             _variance_inertia(variance_inertia),
+            _lifecycle(lifecycle),
+            _snapshot_period(snapshot_period),
             _event_to_blob(std::forward<EventToBlob>(event_to_blob)),
-            _handle_blob(std::forward<HandleBlob>(handle_blob)) {
+            _handle_blob(std::forward<HandleBlob>(handle_blob)),
+            _slots(lifecycle.capacity, slot{0, std::numeric_limits<uint64_t>::max(), 0.0f, 0}),
+            _unassigned_events(
+                4 * static_cast<std::size_t>(lifecycle.spawn_events),
+                unassigned_event{0, 0.0f, 0.0f, 1}),
+            _unassigned_index(0),
+            _started(false),
+            _next_snapshot_t(0) {
             if (_prob_threshold < 0 || _prob_threshold > 1) {
                 throw std::logic_error("prob_threshold must be in the range [0, 1]");
             }
@@ -33,6 +122,32 @@ namespace tarsier {
             if (_variance_inertia < 0 || _variance_inertia > 1) {
                 throw std::logic_error("variance_inertia must be in the range [0, 1]");
             }
+            if (_multi_blobs.blobs.size() > _lifecycle.capacity) {
+                throw std::logic_error("capacity must be larger than or equal to the number of blobs");
+            }
+            if (_lifecycle.activity_decay < 0) {
+                throw std::logic_error("activity_decay must be larger than or equal to 0");
+            }
+            if (_lifecycle.spawn_events > 0 && _lifecycle.spawn_variance <= 0) {
+                throw std::logic_error("spawn_variance must be larger than 0");
+            }
+            if (!decltype(has_timestamp<Event>(0))::value
+                && (_lifecycle.activity_decay > 0 || _lifecycle.spawn_events > 0 || _snapshot_period > 0)) {
+                throw std::logic_error("Event must have a t field to decay the activities, spawn blobs or snapshot");
+            }
+            const auto blobs = _multi_blobs.blobs.size();
+            _multi_blobs.blobs.resize(_lifecycle.capacity);
+            _alive_ids.reserve(_lifecycle.capacity);
+            _free_ids.reserve(_lifecycle.capacity);
+            for (std::size_t id = 0; id < _lifecycle.capacity; ++id) {
+                if (id < blobs) {
+                    _slots[id].activity = _lifecycle.spawn_events > 0 ? _lifecycle.spawn_events : 1.0f;
+                    _slots[id].alive = 1;
+                    _alive_ids.push_back(static_cast<uint16_t>(id));
+                } else {
+                    _free_ids.push_back(static_cast<uint16_t>(_lifecycle.capacity - 1 - (id - blobs)));
+                }
+            }
         }
         track_blob_multi(const track_blob_multi&) = delete;
         track_blob_multi(track_blob_multi&&) = default;
@@ -42,10 +157,24 @@ namespace tarsier {
 
         /// operator() handles an event.
         virtual void operator()(Event event) {
+            const auto t = timestamp(event, 0);
+            if (!_started) {
+                // the initial blobs' activity starts decaying with the first event
+                _started = true;
+                for (auto id : _alive_ids) {
+                    touch(id, t);
+                }
+            }
             uint16_t max_id = 0;
-            float max_prob = 0.0f;
-            // compute probability of each tracker
-            for (uint16_t i = 0; i < _multi_blobs.blobs.size(); i++) {
+            float max_prob = -1.0f;
+            // compute probability of each living tracker, and remove the inactive ones
+            for (std::size_t index = 0; index < _alive_ids.size();) {
+                const auto i = _alive_ids[index];
+                if (t > _slots[i].expiry_t) {
+                    kill(event, index);
+                    continue;
+                }
+                ++index;
                 auto sigma_x_squared = _multi_blobs.blobs[i].sigma_x_squared;
                 auto sigma_xy = _multi_blobs.blobs[i].sigma_xy;
                 auto sigma_y_squared = _multi_blobs.blobs[i].sigma_y_squared;
@@ -53,10 +182,10 @@ namespace tarsier {
                 const auto det = sigma_x_squared * sigma_y_squared - sigma_xy * sigma_xy;
                 const auto x_delta = event.x - _multi_blobs.blobs[i].x;
                 const auto y_delta = event.y - _multi_blobs.blobs[i].y;
-                const auto exp_power = -0.5 / det * (x_delta * x_delta * sigma_y_squared +
-                                                     y_delta * y_delta * sigma_x_squared);
+                const auto exp_power =
+                    -0.5 / det * (x_delta * x_delta * sigma_y_squared + y_delta * y_delta * sigma_x_squared);
                 float prob = std::pow(det, -0.5) * std::exp(exp_power) / (2 * M_PI);
-                
+
                 if (prob > max_prob) {
                     max_prob = prob;
                     max_id = i;
@@ -66,27 +195,295 @@ namespace tarsier {
             // update tracker
             if (max_prob >= _prob_threshold) {
                 _multi_blobs.id = max_id;
-                const auto x_delta = event.x - _multi_blobs.blobs[max_id].x;
-                const auto y_delta = event.y - _multi_blobs.blobs[max_id].y;
-                _multi_blobs.blobs[max_id].x = _position_inertia * _multi_blobs.blobs[max_id].x + (1 - _position_inertia) * event.x;
-                _multi_blobs.blobs[max_id].y = _position_inertia * _multi_blobs.blobs[max_id].y + (1 - _position_inertia) * event.y;
-                _multi_blobs.blobs[max_id].sigma_x_squared = _variance_inertia * _multi_blobs.blobs[max_id].sigma_x_squared + (1 - _variance_inertia) * x_delta * x_delta;
-                _multi_blobs.blobs[max_id].sigma_xy = _variance_inertia * _multi_blobs.blobs[max_id].sigma_xy + (1 - _variance_inertia) * x_delta * y_delta;
-                _multi_blobs.blobs[max_id].sigma_y_squared = _variance_inertia * _multi_blobs.blobs[max_id].sigma_y_squared + (1 - _variance_inertia) * y_delta * y_delta;
+                auto& blob = _multi_blobs.blobs[max_id];
+                const auto x_delta = event.x - blob.x;
+                const auto y_delta = event.y - blob.y;
+                blob.x = _position_inertia * blob.x + (1 - _position_inertia) * event.x;
+                blob.y = _position_inertia * blob.y + (1 - _position_inertia) * event.y;
+                blob.sigma_x_squared =
+                    _variance_inertia * blob.sigma_x_squared + (1 - _variance_inertia) * x_delta * x_delta;
+                blob.sigma_xy = _variance_inertia * blob.sigma_xy + (1 - _variance_inertia) * x_delta * y_delta;
+                blob.sigma_y_squared =
+                    _variance_inertia * blob.sigma_y_squared + (1 - _variance_inertia) * y_delta * y_delta;
+                _slots[max_id].activity = activity(max_id, t) + 1;
+                touch(max_id, t);
+                if (_lifecycle.merge_distance > 0) {
+                    max_id = merge_into(event, max_id);
+                }
+                _handle_blob(_event_to_blob(event, max_id, blob_status::update, _multi_blobs.blobs[max_id]));
+            } else if (_lifecycle.spawn_events > 0) {
+                spawn(event);
+            }
+
+            if (_snapshot_period > 0 && t >= _next_snapshot_t) {
+                _next_snapshot_t = t + _snapshot_period;
+                for (auto id : _alive_ids) {
+                    _handle_blob(_event_to_blob(event, id, blob_status::snapshot, _multi_blobs.blobs[id]));
+                }
             }
+        }
 
-            // TODO: compute tracker activity
+        /// alive returns true if the given blob slot contains a living blob.
+        bool alive(uint16_t id) const {
+            return _slots[id].alive == 1;
+        }
+
+        /// activity returns the activity of the given blob at the given time.
+        float activity(uint16_t id, uint64_t t) const {
+            if (_lifecycle.activity_decay == 0 || t <= _slots[id].t) {
+                return _slots[id].activity;
+            }
+            return _slots[id].activity * std::exp(-static_cast<float>(t - _slots[id].t) / _lifecycle.activity_decay);
+        }
+
+        /// alive_ids returns the ids of the living blobs, in no particular order.
+        const std::vector<uint16_t>& alive_ids() const {
+            return _alive_ids;
+        }
+
+        /// save_state writes the handler's state to a stream.
+        void save_state(std::ostream& stream) const {
+            state_format::write_header(stream, "track_blob_multi");
+            state_format::write_value(stream, _multi_blobs.id);
+            state_format::write_buffer(stream, _multi_blobs.blobs);
+            state_format::write_field(stream, _slots, &slot::t);
+            state_format::write_field(stream, _slots, &slot::expiry_t);
+            state_format::write_field(stream, _slots, &slot::activity);
+            state_format::write_field(stream, _slots, &slot::alive);
+            state_format::write_field(stream, _unassigned_events, &unassigned_event::t);
+            state_format::write_field(stream, _unassigned_events, &unassigned_event::x);
+            state_format::write_field(stream, _unassigned_events, &unassigned_event::y);
+            state_format::write_field(stream, _unassigned_events, &unassigned_event::used);
+            state_format::write_value(stream, static_cast<uint64_t>(_unassigned_index));
+            state_format::write_value(stream, static_cast<uint8_t>(_started ? 1 : 0));
+            state_format::write_value(stream, _next_snapshot_t);
+        }
 
-            _handle_blob(_event_to_blob(event, _multi_blobs));
+        /// load_state restores a state written by save_state, and throws if the state does not match.
+        /// The handler must have been constructed with the same parameters.
+        void load_state(std::istream& stream) {
+            state_format::read_header(stream, "track_blob_multi");
+            state_format::read_value(stream, _multi_blobs.id);
+            state_format::read_buffer(stream, _multi_blobs.blobs);
+            state_format::read_field(stream, _slots, &slot::t);
+            state_format::read_field(stream, _slots, &slot::expiry_t);
+            state_format::read_field(stream, _slots, &slot::activity);
+            state_format::read_field(stream, _slots, &slot::alive);
+            state_format::read_field(stream, _unassigned_events, &unassigned_event::t);
+            state_format::read_field(stream, _unassigned_events, &unassigned_event::x);
+            state_format::read_field(stream, _unassigned_events, &unassigned_event::y);
+            state_format::read_field(stream, _unassigned_events, &unassigned_event::used);
+            uint64_t unassigned_index;
+            state_format::read_value(stream, unassigned_index);
+            _unassigned_index = static_cast<std::size_t>(unassigned_index);
+            uint8_t started;
+            state_format::read_value(stream, started);
+            _started = started == 1;
+            state_format::read_value(stream, _next_snapshot_t);
+            _alive_ids.clear();
+            _free_ids.clear();
+            for (std::size_t id = 0; id < _slots.size(); ++id) {
+                if (_slots[id].alive == 1) {
+                    _alive_ids.push_back(static_cast<uint16_t>(id));
+                }
+            }
+            for (std::size_t id = _slots.size(); id > 0; --id) {
+                if (_slots[id - 1].alive == 0) {
+                    _free_ids.push_back(static_cast<uint16_t>(id - 1));
+                }
+            }
         }
 
         protected:
+        /// slot stores the lifecycle variables of a blob slot.
+        struct slot {
+            uint64_t t;
+            uint64_t expiry_t;
+            float activity;
+            uint8_t alive;
+        };
+
+        /// unassigned_event stores an event that was not assigned to a blob.
+        struct unassigned_event {
+            uint64_t t;
+            float x;
+            float y;
+            uint8_t used;
+        };
+
+        /// has_timestamp is std::true_type if Type has a t field, and std::false_type otherwise.
+        template <typename Type>
+        static auto has_timestamp(int) -> decltype(std::declval<Type>().t, std::true_type());
+        template <typename Type>
+        static std::false_type has_timestamp(long);
+
+        /// timestamp returns an event's t field, or 0 if the event has none.
+        /// The second parameter selects the first overload when it is well-formed.
+        template <typename Type>
+        static auto timestamp(const Type& event, int) -> decltype(static_cast<uint64_t>(event.t)) {
+            return event.t;
+        }
+        template <typename Type>
+        static uint64_t timestamp(const Type&, long) {
+            return 0;
+        }
+
+        /// touch sets the time of a blob's activity, and computes the time at which the blob becomes inactive.
+        void touch(uint16_t id, uint64_t t) {
+            auto& slot = _slots[id];
+            slot.t = t;
+            if (_lifecycle.activity_decay == 0) {
+                slot.expiry_t = std::numeric_limits<uint64_t>::max();
+            } else if (slot.activity <= _lifecycle.kill_activity) {
+                slot.expiry_t = t;
+            } else if (_lifecycle.kill_activity <= 0) {
+                slot.expiry_t = std::numeric_limits<uint64_t>::max();
+            } else {
+                const auto duration =
+                    _lifecycle.activity_decay * std::log(slot.activity / _lifecycle.kill_activity);
+                slot.expiry_t = duration >= static_cast<float>(std::numeric_limits<uint64_t>::max() - t) ?
+                                    std::numeric_limits<uint64_t>::max() :
+                                    t + static_cast<uint64_t>(duration);
+            }
+        }
+
+        /// kill removes the living blob at the given index of _alive_ids, and frees its slot.
+        void kill(Event event, std::size_t index) {
+            const auto id = _alive_ids[index];
+            _slots[id].alive = 0;
+            _alive_ids[index] = _alive_ids.back();
+            _alive_ids.pop_back();
+            _free_ids.push_back(id);
+            _handle_blob(_event_to_blob(event, id, blob_status::kill, _multi_blobs.blobs[id]));
+        }
+
+        /// merge_into merges the blobs close to the given blob, and returns the id of the remaining blob.
+        /// The remaining blob is the most active one, and its moments are the activity-weighted moments of both.
+        uint16_t merge_into(Event event, uint16_t id) {
+            const auto t = timestamp(event, 0);
+            const auto squared_distance = _lifecycle.merge_distance * _lifecycle.merge_distance;
+            for (std::size_t index = 0; index < _alive_ids.size();) {
+                const auto other_id = _alive_ids[index];
+                const auto& blob = _multi_blobs.blobs[id];
+                const auto& other = _multi_blobs.blobs[other_id];
+                const auto x_delta = other.x - blob.x;
+                const auto y_delta = other.y - blob.y;
+                if (other_id == id || x_delta * x_delta + y_delta * y_delta >= squared_distance) {
+                    ++index;
+                    continue;
+                }
+                const auto activity_0 = activity(id, t);
+                const auto activity_1 = activity(other_id, t);
+                const auto weight = activity_0 + activity_1 > 0 ? activity_0 / (activity_0 + activity_1) : 0.5f;
+                const auto kept_id = activity_0 >= activity_1 ? id : other_id;
+                auto& kept = _multi_blobs.blobs[kept_id];
+                const auto x = blob.x + (1 - weight) * x_delta;
+                const auto y = blob.y + (1 - weight) * y_delta;
+                const auto spread = weight * (1 - weight);
+                const auto sigma_x_squared = weight * blob.sigma_x_squared + (1 - weight) * other.sigma_x_squared
+                                             + spread * x_delta * x_delta;
+                const auto sigma_xy =
+                    weight * blob.sigma_xy + (1 - weight) * other.sigma_xy + spread * x_delta * y_delta;
+                const auto sigma_y_squared = weight * blob.sigma_y_squared + (1 - weight) * other.sigma_y_squared
+                                             + spread * y_delta * y_delta;
+                kept.x = x;
+                kept.y = y;
+                kept.sigma_x_squared = sigma_x_squared;
+                kept.sigma_xy = sigma_xy;
+                kept.sigma_y_squared = sigma_y_squared;
+                _slots[kept_id].activity = activity_0 + activity_1;
+                touch(kept_id, t);
+                _multi_blobs.id = kept_id;
+                if (kept_id == id) {
+                    kill(event, index);
+                } else {
+                    for (std::size_t removed_index = 0; removed_index < _alive_ids.size(); ++removed_index) {
+                        if (_alive_ids[removed_index] == id) {
+                            kill(event, removed_index);
+                            break;
+                        }
+                    }
+                    id = kept_id;
+                    index = 0;
+                }
+            }
+            return id;
+        }
+
+        /// spawn stores an unassigned event, and creates a blob if enough recent unassigned events are close to it.
+        void spawn(Event event) {
+            const auto t = timestamp(event, 0);
+            _unassigned_events[_unassigned_index] =
+                unassigned_event{t, static_cast<float>(event.x), static_cast<float>(event.y), 0};
+            _unassigned_index = (_unassigned_index + 1) % _unassigned_events.size();
+            if (_free_ids.empty()) {
+                return;
+            }
+            const auto t_threshold = t <= _lifecycle.spawn_window ? 0 : t - _lifecycle.spawn_window;
+            const auto squared_radius = _lifecycle.spawn_radius * _lifecycle.spawn_radius;
+            std::size_t count = 0;
+            auto x_sum = 0.0f;
+            auto y_sum = 0.0f;
+            for (const auto& unassigned : _unassigned_events) {
+                const auto x_delta = unassigned.x - event.x;
+                const auto y_delta = unassigned.y - event.y;
+                if (unassigned.used == 0 && unassigned.t >= t_threshold && unassigned.t <= t
+                    && x_delta * x_delta + y_delta * y_delta <= squared_radius) {
+                    ++count;
+                    x_sum += unassigned.x;
+                    y_sum += unassigned.y;
+                }
+            }
+            if (count < _lifecycle.spawn_events) {
+                return;
+            }
+            const auto x_mean = x_sum / count;
+            const auto y_mean = y_sum / count;
+            auto xx_sum = 0.0f;
+            auto xy_sum = 0.0f;
+            auto yy_sum = 0.0f;
+            for (auto& unassigned : _unassigned_events) {
+                const auto x_delta = unassigned.x - event.x;
+                const auto y_delta = unassigned.y - event.y;
+                if (unassigned.used == 0 && unassigned.t >= t_threshold && unassigned.t <= t
+                    && x_delta * x_delta + y_delta * y_delta <= squared_radius) {
+                    unassigned.used = 1;
+                    xx_sum += (unassigned.x - x_mean) * (unassigned.x - x_mean);
+                    xy_sum += (unassigned.x - x_mean) * (unassigned.y - y_mean);
+                    yy_sum += (unassigned.y - y_mean) * (unassigned.y - y_mean);
+                }
+            }
+            const auto id = _free_ids.back();
+            _free_ids.pop_back();
+            auto& blob = _multi_blobs.blobs[id];
+            blob.x = x_mean;
+            blob.y = y_mean;
+            blob.sigma_x_squared = xx_sum / count + _lifecycle.spawn_variance;
+            blob.sigma_xy = xy_sum / count;
+            blob.sigma_y_squared = yy_sum / count + _lifecycle.spawn_variance;
+            _slots[id].activity = static_cast<float>(count);
+            _slots[id].alive = 1;
+            touch(id, t);
+            _alive_ids.push_back(id);
+            _multi_blobs.id = id;
+            _handle_blob(_event_to_blob(event, id, blob_status::spawn, blob));
+        }
+
         MultiBlobs _multi_blobs;
         const float _prob_threshold;
         const float _position_inertia;
         const float _variance_inertia;
+        const blob_lifecycle _lifecycle;
+        const uint64_t _snapshot_period;
         EventToBlob _event_to_blob;
         HandleBlob _handle_blob;
+        std::vector<slot> _slots;
+        std::vector<unassigned_event> _unassigned_events;
+        std::size_t _unassigned_index;
+        std::vector<uint16_t> _alive_ids;
+        std::vector<uint16_t> _free_ids;
+        bool _started;
+        uint64_t _next_snapshot_t;
     };
 
     /// make_track_blob_multi creates a track_blob_multi from functors.
@@ -106,4 +503,26 @@ namespace tarsier {
             std::forward<EventToBlob>(event_to_blob),
             std::forward<HandleBlob>(handle_blob));
     }
+
+    /// make_track_blob_multi creates a track_blob_multi with a lifecycle from functors.
+    template <typename Event, typename MultiBlobs, typename EventToBlob, typename HandleBlob>
+    inline track_blob_multi<Event, MultiBlobs, EventToBlob, HandleBlob> make_track_blob_multi(
+        MultiBlobs multi_blobs,
+        float prob_threshold,
+        float position_inertia,
+        float variance_inertia,
+        blob_lifecycle lifecycle,
+        uint64_t snapshot_period,
+        EventToBlob&& event_to_blob,
+        HandleBlob&& handle_blob) {
+        return track_blob_multi<Event, MultiBlobs, EventToBlob, HandleBlob>(
+            multi_blobs,
+            prob_threshold,
+            position_inertia,
+            variance_inertia,
+            lifecycle,
+            snapshot_period,
+            std::forward<EventToBlob>(event_to_blob),
+            std::forward<HandleBlob>(handle_blob));
+    }
 }
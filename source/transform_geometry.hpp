@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// geometry composes crops, shifts, mirrors and transpositions into a single
+    /// affine integer map followed by a rectangular bounds check.
+    /// Each operation is applied to the output of the previous one, with the same
+    /// semantics as select_rectangle, shift_x, shift_y, mirror_x and mirror_y.
+    class geometry {
+        public:
+        geometry(uint16_t width, uint16_t height) :
+            _width(width),
+            _height(height),
+            _xx(1),
+            _xy(0),
+            _x_offset(0),
+            _yx(0),
+            _yy(1),
+            _y_offset(0),
+            _left(0),
+            _bottom(0),
+            _right(width),
+            _top(height) {}
+
+        /// crop keeps only the coordinates within the given rectangular window.
+        geometry& crop(uint16_t left, uint16_t bottom, uint16_t width, uint16_t height) {
+            _left = std::max(_left, static_cast<int32_t>(left));
+            _bottom = std::max(_bottom, static_cast<int32_t>(bottom));
+            _right = std::min(_right, static_cast<int32_t>(left) + width);
+            _top = std::min(_top, static_cast<int32_t>(bottom) + height);
+            normalize();
+            return *this;
+        }
+
+        /// shift_x translates the x coordinate, and drops the coordinates outside the sensor.
+        geometry& shift_x(int32_t shift) {
+            _x_offset += shift;
+            _left = std::max(_left + shift, 0);
+            _right = std::min(_right + shift, static_cast<int32_t>(_width));
+            normalize();
+            return *this;
+        }
+
+        /// shift_y translates the y coordinate, and drops the coordinates outside the sensor.
+        geometry& shift_y(int32_t shift) {
+            _y_offset += shift;
+            _bottom = std::max(_bottom + shift, 0);
+            _top = std::min(_top + shift, static_cast<int32_t>(_height));
+            normalize();
+            return *this;
+        }
+
+        /// mirror_x inverts the x coordinate.
+        geometry& mirror_x() {
+            _xx = -_xx;
+            _xy = -_xy;
+            _x_offset = _width - 1 - _x_offset;
+            const auto left = _width - _right;
+            _right = _width - _left;
+            _left = left;
+            return *this;
+        }
+
+        /// mirror_y inverts the y coordinate.
+        geometry& mirror_y() {
+            _yx = -_yx;
+            _yy = -_yy;
+            _y_offset = _height - 1 - _y_offset;
+            const auto bottom = _height - _top;
+            _top = _height - _bottom;
+            _bottom = bottom;
+            return *this;
+        }
+
+        /// transpose swaps the x and y coordinates.
+        geometry& transpose() {
+            std::swap(_width, _height);
+            std::swap(_xx, _yx);
+            std::swap(_xy, _yy);
+            std::swap(_x_offset, _y_offset);
+            std::swap(_left, _bottom);
+            std::swap(_right, _top);
+            return *this;
+        }
+
+        /// width returns the width of the output coordinates space.
+        uint16_t width() const {
+            return _width;
+        }
+
+        /// height returns the height of the output coordinates space.
+        uint16_t height() const {
+            return _height;
+        }
+
+        /// apply maps the given coordinates, and returns false if they are dropped.
+        bool apply(int32_t& x, int32_t& y) const {
+            const auto input_x = x;
+            x = _xx * input_x + _xy * y + _x_offset;
+            y = _yx * input_x + _yy * y + _y_offset;
+            return static_cast<uint32_t>(x - _left) < static_cast<uint32_t>(_right - _left)
+                   && static_cast<uint32_t>(y - _bottom) < static_cast<uint32_t>(_top - _bottom);
+        }
+
+        protected:
+        /// normalize collapses an empty window, so that apply needs a single
+        /// unsigned comparison per coordinate.
+        void normalize() {
+            _right = std::max(_right, _left);
+            _top = std::max(_top, _bottom);
+        }
+
+        uint16_t _width;
+        uint16_t _height;
+        int32_t _xx;
+        int32_t _xy;
+        int32_t _x_offset;
+        int32_t _yx;
+        int32_t _yy;
+        int32_t _y_offset;
+        int32_t _left;
+        int32_t _bottom;
+        int32_t _right;
+        int32_t _top;
+    };
+
+    /// transform_geometry applies a composed geometry to the events, and
+    /// propagates only the events within the output window.
+    template <typename Event, typename HandleEvent>
+    class transform_geometry {
+        public:
+        transform_geometry(geometry transform, HandleEvent&& handle_event) :
+            _transform(transform),
+            _handle_event(std::forward<HandleEvent>(handle_event)) {}
+        transform_geometry(const transform_geometry&) = delete;
+        transform_geometry(transform_geometry&&) = default;
+        transform_geometry& operator=(const transform_geometry&) = delete;
+        transform_geometry& operator=(transform_geometry&&) = default;
+        virtual ~transform_geometry() = default;
+
+        /// operator() handles an event.
+        virtual void operator()(Event event) {
+            int32_t x = event.x;
+            int32_t y = event.y;
+            if (_transform.apply(x, y)) {
+                event.x = x;
+                event.y = y;
+                _handle_event(event);
+            }
+        }
+
+        protected:
+        const geometry _transform;
+        HandleEvent _handle_event;
+    };
+
+    /// make_transform_geometry creates a transform_geometry from a functor.
+    template <typename Event, typename HandleEvent>
+    inline transform_geometry<Event, HandleEvent>
+    make_transform_geometry(geometry transform, HandleEvent&& handle_event) {
+        return transform_geometry<Event, HandleEvent>(transform, std::forward<HandleEvent>(handle_event));
+    }
+}
@@ -0,0 +1,156 @@
+#include "../source/accumulate_frame.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        bool polarity;
+    };
+}
+
+TEST_CASE("Accumulate frames over time windows", "[accumulate_frame]") {
+    std::vector<std::vector<uint8_t>> frames;
+    std::vector<uint64_t> ts;
+    auto accumulate_frame = tarsier::make_accumulate_frame<event, uint8_t>(
+        4,
+        3,
+        tarsier::frame_window::time,
+        100,
+        0,
+        0.0f,
+        [&](tarsier::frame_view<uint8_t> frame) -> void {
+            ts.push_back(frame.t);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(frame.pixels) % 64 == 0);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(frame.pixels + frame.stride) % 64 == 0);
+            frames.push_back({frame.at(false, 1, 2), frame.at(true, 1, 2), frame.at(false, 3, 0)});
+        });
+    for (uint64_t t = 0; t < 300; ++t) {
+        accumulate_frame(event{t, 1, 2, false});
+    }
+    for (uint64_t t = 300; t < 400; ++t) {
+        accumulate_frame(event{t, 1, 2, true});
+    }
+    accumulate_frame(event{400, 3, 0, false});
+    accumulate_frame(event{1000, 3, 0, false});
+    // a frame is passed by the first event past its window, hence the last event is not passed
+    // the empty windows between 500 and 1000 are skipped
+    REQUIRE(
+        frames
+        == std::vector<std::vector<uint8_t>>({{100, 0, 0}, {100, 0, 0}, {100, 0, 0}, {0, 100, 0}, {0, 0, 1}}));
+    REQUIRE(ts == std::vector<uint64_t>({100, 200, 300, 400, 500}));
+}
+
+TEST_CASE("Accumulate frames over time windows aligned on the first event", "[accumulate_frame]") {
+    std::vector<uint64_t> ts;
+    std::vector<uint8_t> counts;
+    auto accumulate_frame = tarsier::make_accumulate_frame<event, uint8_t>(
+        4,
+        3,
+        tarsier::frame_window::time,
+        100,
+        0,
+        0.0f,
+        [&](tarsier::frame_view<uint8_t> frame) -> void {
+            ts.push_back(frame.t);
+            counts.push_back(frame.at(true, 2, 1));
+        });
+    for (auto t : {1000000, 1000010, 1000150, 1000160, 1000210, 1000260, 1000330, 1000420}) {
+        accumulate_frame(event{static_cast<uint64_t>(t), 2, 1, true});
+    }
+    REQUIRE(ts == std::vector<uint64_t>({1000100, 1000200, 1000300, 1000400}));
+    REQUIRE(counts == std::vector<uint8_t>({2, 2, 2, 1}));
+}
+
+TEST_CASE("Accumulate frames over event counts", "[accumulate_frame]") {
+    std::vector<std::vector<uint16_t>> frames;
+    auto accumulate_frame = tarsier::make_accumulate_frame<event, uint16_t>(
+        4,
+        3,
+        tarsier::frame_window::count,
+        3,
+        0,
+        0.0f,
+        [&](tarsier::frame_view<uint16_t> frame) -> void {
+            frames.push_back({frame.at(false, 0, 0), frame.at(true, 0, 0), frame.at(false, 2, 2)});
+        });
+    accumulate_frame(event{0, 0, 0, false});
+    accumulate_frame(event{1, 0, 0, true});
+    accumulate_frame(event{2, 0, 0, true});
+    accumulate_frame(event{3, 2, 2, false});
+    accumulate_frame(event{4, 2, 2, false});
+    REQUIRE(frames.size() == 1);
+    accumulate_frame(event{5, 0, 0, false});
+    REQUIRE(frames == std::vector<std::vector<uint16_t>>({{1, 2, 0}, {1, 0, 2}}));
+
+    // integer counts saturate
+    uint8_t saturated_count = 0;
+    auto saturated_accumulate_frame = tarsier::make_accumulate_frame<event, uint8_t>(
+        4,
+        3,
+        tarsier::frame_window::count,
+        300,
+        0,
+        0.0f,
+        [&](tarsier::frame_view<uint8_t> frame) -> void { saturated_count = frame.at(true, 3, 2); });
+    for (uint64_t t = 0; t < 300; ++t) {
+        saturated_accumulate_frame(event{t, 3, 2, true});
+    }
+    REQUIRE(saturated_count == 255);
+}
+
+TEST_CASE("Accumulate frames over a sliding window", "[accumulate_frame]") {
+    std::vector<std::vector<float>> frames;
+    auto accumulate_frame = tarsier::make_accumulate_frame<event, float>(
+        4,
+        3,
+        tarsier::frame_window::sliding,
+        4,
+        2,
+        0.0f,
+        [&](tarsier::frame_view<float> frame) -> void {
+            frames.push_back({frame.at(false, 0, 0), frame.at(false, 1, 0), frame.at(true, 1, 0)});
+        });
+    for (uint64_t t = 0; t < 4; ++t) {
+        accumulate_frame(event{t, 0, 0, false});
+    }
+    for (uint64_t t = 4; t < 8; ++t) {
+        accumulate_frame(event{t, 1, 0, t % 2 == 0});
+    }
+    REQUIRE(frames == std::vector<std::vector<float>>({{2, 0, 0}, {4, 0, 0}, {2, 1, 1}, {0, 2, 2}}));
+}
+
+TEST_CASE("Accumulate frames with an exponential decay", "[accumulate_frame]") {
+    std::vector<float> values;
+    auto accumulate_frame = tarsier::make_accumulate_frame<event, float>(
+        4,
+        3,
+        tarsier::frame_window::time,
+        100,
+        0,
+        50.0f,
+        [&](tarsier::frame_view<float> frame) -> void {
+            values.push_back(frame.at(true, 3, 2));
+        });
+    accumulate_frame(event{10, 3, 2, true});
+    accumulate_frame(event{60, 3, 2, true});
+    accumulate_frame(event{110, 0, 0, true});
+    accumulate_frame(event{260, 0, 0, true});
+    REQUIRE(values.size() == 2);
+    REQUIRE(std::abs(values[0] - (std::exp(-1.0f) + 1.0f) * std::exp(-1.0f)) < 1e-5f);
+    REQUIRE(std::abs(values[1] - (std::exp(-1.0f) + 1.0f) * std::exp(-3.0f)) < 1e-5f);
+    // the decay requires floating point pixels
+    auto make_integer_decay = []() -> void {
+        tarsier::make_accumulate_frame<event, uint8_t>(
+            4,
+            3,
+            tarsier::frame_window::time,
+            100,
+            0,
+            50.0f,
+            [](tarsier::frame_view<uint8_t>) -> void {});
+    };
+    REQUIRE_THROWS_AS(make_integer_decay(), std::logic_error);
+}
@@ -1,30 +1,33 @@
 #include "../source/average_grid.hpp"
 #include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
 #include <vector>
 
-struct event {
-    uint16_t x;
-    uint16_t y;
-};
+namespace {
+    struct event {
+        uint16_t x;
+        uint16_t y;
+    };
 
-struct Position {
-    float cx;
-    float cy;
-    bool valid;
-};
+    struct Position {
+        float cx;
+        float cy;
+        bool valid;
+    };
 
-typedef std::vector<std::vector<Position>> Grid;
+    typedef std::vector<std::vector<Position>> Grid;
 
-struct Centroids {
-    std::vector<std::vector<Position>> grid;
-    uint16_t ir;
-    uint16_t ic;
-};
+    struct Centroids {
+        std::vector<std::vector<Position>> grid;
+        uint16_t ir;
+        uint16_t ic;
+    };
 
 
-Grid grid = {{{1, 1, true}, {4, 1, true}, {7, 1, true}},
-             {{1, 4, true}, {4, 4, true}, {7, 4, true}},
-             {{1, 7, true}, {4, 7, true}, {7, 7, false}}};
+    Grid grid = {{{1, 1, true}, {4, 1, true}, {7, 1, true}},
+                 {{1, 4, true}, {4, 4, true}, {7, 4, true}},
+                 {{1, 7, true}, {4, 7, true}, {7, 7, false}}};
+}
 
 TEST_CASE("Average the position of the given events in a grid", "[average_grid]") {
     auto first_received = false;
@@ -58,3 +61,70 @@ TEST_CASE("Average the position of the given events in a grid", "[average_grid]"
     average_grid(event{5, 2});
     average_grid(event{8, 8});
 }
+
+namespace {
+    struct timestamped_event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+}
+
+TEST_CASE("Average the position of the given events in a grid over time", "[average_grid]") {
+    std::vector<Centroids> centroids;
+    auto average_grid = tarsier::make_temporal_average_grid<timestamped_event, Grid>(
+        grid,
+        3.0,
+        100.0f,
+        20,
+        [](timestamped_event, Grid grid, uint16_t ir, uint16_t ic) -> Centroids {
+            return {grid, ir, ic};
+        },
+        [&](Centroids grid_centroids) -> void { centroids.push_back(grid_centroids); });
+    average_grid(timestamped_event{100, 2, 2});
+    average_grid(timestamped_event{110, 5, 2});
+    REQUIRE(centroids.size() == 1);
+    average_grid(timestamped_event{200, 2, 2});
+    REQUIRE(centroids.size() == 2);
+    // the first cell decays over 100 timestamp units between its two events
+    const auto inertia = std::exp(-1.0f);
+    const auto cx = (1.0f - inertia) * 2.0f + inertia * (std::exp(-1.0f) * 1.0f + (1.0f - std::exp(-1.0f)) * 2.0f);
+    REQUIRE(std::abs(centroids.back().grid[0][0].cx - cx) < 1e-3f);
+    REQUIRE(
+        std::abs(centroids.back().grid[0][1].cx - (std::exp(-1.1f) * 4.0f + (1.0f - std::exp(-1.1f)) * 5.0f)) < 1e-3f);
+}
+
+TEST_CASE("Save and load the state of a grid", "[average_grid]") {
+    std::vector<Centroids> centroids;
+    auto average_grid = tarsier::make_average_grid<event, Grid>(
+        grid,
+        3.0,
+        0.5,
+        [](event, Grid grid, uint16_t ir, uint16_t ic) -> Centroids {
+            return {grid, ir, ic};
+        },
+        [&](Centroids grid_centroids) -> void { centroids.push_back(grid_centroids); });
+    average_grid(event{0, 0});
+    average_grid(event{5, 2});
+    std::stringstream stream;
+    average_grid.save_state(stream);
+    std::vector<Centroids> restored_centroids;
+    auto restored_average_grid = tarsier::make_average_grid<event, Grid>(
+        grid,
+        3.0,
+        0.5,
+        [](event, Grid grid, uint16_t ir, uint16_t ic) -> Centroids {
+            return {grid, ir, ic};
+        },
+        [&](Centroids grid_centroids) -> void { restored_centroids.push_back(grid_centroids); });
+    restored_average_grid.load_state(stream);
+    average_grid(event{2, 2});
+    restored_average_grid(event{2, 2});
+    REQUIRE(restored_centroids.size() == 1);
+    for (std::size_t ir = 0; ir < grid.size(); ++ir) {
+        for (std::size_t ic = 0; ic < grid[ir].size(); ++ic) {
+            REQUIRE(restored_centroids.back().grid[ir][ic].cx == centroids.back().grid[ir][ic].cx);
+            REQUIRE(restored_centroids.back().grid[ir][ic].cy == centroids.back().grid[ir][ic].cy);
+        }
+    }
+}
@@ -1,15 +1,18 @@
 #include "../source/average_position.hpp"
 #include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
 
-struct event {
-    uint16_t x;
-    uint16_t y;
-};
+namespace {
+    struct event {
+        uint16_t x;
+        uint16_t y;
+    };
 
-struct position {
-    float x;
-    float y;
-};
+    struct position {
+        float x;
+        float y;
+    };
+}
 
 TEST_CASE("Average the position of the given events", "[average_position]") {
     auto first_received = false;
@@ -31,3 +34,36 @@ TEST_CASE("Average the position of the given events", "[average_position]") {
     average_position(event{0, 0});
     average_position(event{200, 100});
 }
+
+namespace {
+    struct timestamped_event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+}
+
+TEST_CASE("Average the position of the given events over time", "[average_position]") {
+    std::vector<position> positions;
+    auto average_position = tarsier::make_temporal_average_position<timestamped_event, position>(
+        0.0f,
+        0.0f,
+        100.0f,
+        50,
+        [](timestamped_event, float x, float y) -> position {
+            return {x, y};
+        },
+        [&](position position) -> void { positions.push_back(position); });
+    average_position(timestamped_event{100, 200, 100});
+    REQUIRE(positions.size() == 1);
+    REQUIRE(std::abs(positions.back().x - 200.0f * (1.0f - std::exp(-1.0f))) < 1e-3f);
+
+    // ten events at the same position over 100 timestamp units weigh as much as a single event
+    for (uint64_t t = 110; t <= 200; t += 10) {
+        average_position(timestamped_event{t, 200, 100});
+    }
+    // the position is passed at t = 150 and t = 200, at most once per 50 timestamp units
+    REQUIRE(positions.size() == 3);
+    REQUIRE(std::abs(positions.back().x - 200.0f * (1.0f - std::exp(-2.0f))) < 1e-3f);
+    REQUIRE(std::abs(positions.back().y - 100.0f * (1.0f - std::exp(-2.0f))) < 1e-3f);
+}
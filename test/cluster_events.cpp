@@ -0,0 +1,79 @@
+#include "../source/cluster_events.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
+#include <vector>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct cluster {
+        uint32_t label;
+        tarsier::cluster_statistics statistics;
+    };
+}
+
+TEST_CASE("Cluster events into connected components", "[cluster_events]") {
+    std::vector<cluster> clusters;
+    auto cluster_events = tarsier::make_cluster_events<event, cluster>(
+        20,
+        10,
+        100,
+        2,
+        [](event, uint32_t label, const tarsier::cluster_statistics& statistics) -> cluster {
+            return {label, statistics};
+        },
+        [&](cluster cluster) -> void { clusters.push_back(cluster); });
+
+    // two separate lines start two clusters
+    for (uint16_t x = 2; x < 5; ++x) {
+        cluster_events(event{x, x, 3});
+    }
+    for (uint16_t x = 8; x < 10; ++x) {
+        cluster_events(event{x, x, 3});
+    }
+    REQUIRE(clusters.size() == 5);
+    REQUIRE(clusters[2].label == 1);
+    REQUIRE(clusters[2].statistics.events == 3);
+    REQUIRE(clusters[2].statistics.x == 3.0f);
+    REQUIRE(clusters[4].label == 2);
+    REQUIRE(clusters[4].statistics.left == 8);
+
+    // every label is in use, hence an isolated event is ignored
+    cluster_events(event{10, 15, 8});
+    REQUIRE(clusters.size() == 5);
+
+    // a diagonal bridge merges the second cluster into the first one, which is larger
+    cluster_events(event{20, 5, 4});
+    cluster_events(event{21, 6, 3});
+    cluster_events(event{22, 7, 4});
+    REQUIRE(clusters.size() == 8);
+    REQUIRE(clusters.back().label == 1);
+    REQUIRE(clusters.back().statistics.events == 8);
+    REQUIRE(clusters.back().statistics.left == 2);
+    REQUIRE(clusters.back().statistics.right == 9);
+    REQUIRE(clusters.back().statistics.bottom == 4);
+    REQUIRE(std::abs(clusters.back().statistics.x - (2 + 3 + 4 + 8 + 9 + 5 + 6 + 7) / 8.0f) < 1e-5f);
+    REQUIRE(clusters.back().statistics.first_t == 2);
+    cluster_events(event{30, 10, 3});
+    REQUIRE(clusters.back().label == 1);
+
+    // once the cluster is inactive for the temporal window, its pixels are no longer neighbours,
+    // and its label is recycled
+    cluster_events(event{130, 11, 3});
+    REQUIRE(clusters.size() == 10);
+    REQUIRE(clusters.back().statistics.events == 1);
+    REQUIRE(clusters.back().statistics.first_t == 130);
+
+    // the state round-trips
+    std::stringstream stream;
+    cluster_events.save_state(stream);
+    cluster_events(event{131, 12, 3});
+    const auto events = clusters.back().statistics.events;
+    cluster_events.load_state(stream);
+    cluster_events(event{131, 12, 3});
+    REQUIRE(clusters.back().statistics.events == events);
+}
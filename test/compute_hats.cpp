@@ -0,0 +1,81 @@
+#include "../source/compute_hats.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        bool polarity;
+    };
+}
+
+TEST_CASE("Match time surfaces summed per cell", "[compute_hats]") {
+    const uint16_t spatial_window = 2;
+    const std::size_t projections_size = (2 * spatial_window + 1) * (2 * spatial_window + 1);
+    const uint16_t cell_size = 8;
+    std::vector<float> expected_histograms(4 * 3 * 2 * projections_size, 0.0f);
+    std::vector<float> expected_counts(4 * 3 * 2, 0.0f);
+    auto compute_time_surface = tarsier::make_compute_time_surface<event, bool, int, spatial_window>(
+        32,
+        24,
+        10000,
+        1000,
+        [&](event event, std::array<std::pair<float, bool>, projections_size> projections_and_polarities) -> int {
+            const auto index = (event.x / cell_size + (event.y / cell_size) * 4) * 2 + (event.polarity ? 1 : 0);
+            for (std::size_t projection_index = 0; projection_index < projections_size; ++projection_index) {
+                if (projections_and_polarities[projection_index].second == event.polarity) {
+                    expected_histograms[index * projections_size + projection_index] +=
+                        projections_and_polarities[projection_index].first;
+                }
+            }
+            expected_counts[index] += 1.0f;
+            return 0;
+        },
+        [](int) {});
+    auto compute_hats = tarsier::make_compute_hats<event, spatial_window>(32, 24, cell_size, 10000, 1000, 0);
+    uint32_t state = 1;
+    for (uint64_t t = 0; t < 20000; t += 3) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const event event{
+            t,
+            static_cast<uint16_t>(state % 32),
+            static_cast<uint16_t>((state >> 8) % 24),
+            (state >> 16) % 2 == 0,
+        };
+        compute_time_surface(event);
+        compute_hats(event);
+    }
+    std::vector<float> features;
+    compute_hats.features(features);
+    REQUIRE(features.size() == compute_hats.size());
+    REQUIRE(features.size() == expected_histograms.size());
+    for (std::size_t index = 0; index < features.size(); ++index) {
+        const auto count = expected_counts[index / projections_size];
+        const auto expected_feature = count > 0 ? expected_histograms[index] / count : 0.0f;
+        REQUIRE(std::abs(features[index] - expected_feature) < 1e-4f);
+    }
+    compute_hats.reset();
+    compute_hats.features(features);
+    for (auto feature : features) {
+        REQUIRE(feature == 0.0f);
+    }
+}
+
+TEST_CASE("Decay the histograms lazily", "[compute_hats]") {
+    auto compute_hats = tarsier::make_compute_hats<event, 1>(16, 16, 4, 10000, 1000, 500);
+    compute_hats(event{1000, 0, 0, true});
+    compute_hats(event{1500, 1, 0, true});
+    std::vector<float> features;
+    compute_hats.features(features);
+    const auto count = 1.0f + std::exp(-1.0f);
+    // first cell, polarity true: the second event sees the first one on its left
+    REQUIRE(std::abs(features[9 + 4] - 1.0f) < 1e-5f);
+    REQUIRE(std::abs(features[9 + 3] - std::exp(-0.5f) / count) < 1e-5f);
+    REQUIRE(features[9 + 5] == 0.0f);
+    for (std::size_t index = 0; index < 9; ++index) {
+        REQUIRE(features[index] == 0.0f);
+    }
+}
@@ -0,0 +1,94 @@
+#include "../source/compute_pyramid_flow.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct flow {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        float vx;
+        float vy;
+    };
+
+    // edge_events generates the events of a vertical edge moving along x at the given speed, in pixels per microsecond.
+    std::vector<event> edge_events(uint16_t width, uint16_t height, float speed) {
+        std::vector<event> events;
+        for (uint16_t x = 0; x < width; ++x) {
+            for (uint16_t y = 0; y < height; ++y) {
+                events.push_back(event{static_cast<uint64_t>(1000 + x / speed), x, y});
+            }
+        }
+        return events;
+    }
+}
+
+TEST_CASE("Compute the optical flow of a slow edge", "[compute_pyramid_flow]") {
+    auto flows = 0;
+    auto compute_pyramid_flow = tarsier::make_compute_pyramid_flow<event, flow>(
+        128,
+        64,
+        4,
+        2,
+        100000,
+        8,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void {
+            ++flows;
+            REQUIRE(std::abs(flow.vx - 0.01f) < 1e-3f);
+            REQUIRE(std::abs(flow.vy) < 1e-3f);
+        });
+    for (auto event : edge_events(128, 64, 0.01f)) {
+        compute_pyramid_flow(event);
+    }
+    REQUIRE(flows > 1000);
+}
+
+TEST_CASE("Compute the optical flow of a fast edge", "[compute_pyramid_flow]") {
+    // at 4 pixels per microsecond, the full-resolution timestamps are quantised to blocks of 4 columns
+    auto fine_flows = 0;
+    auto compute_fine_flow = tarsier::make_compute_pyramid_flow<event, flow>(
+        128,
+        64,
+        1,
+        1,
+        100,
+        5,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow) -> void { ++fine_flows; });
+    auto flows = 0;
+    auto accurate_flows = 0;
+    auto compute_pyramid_flow = tarsier::make_compute_pyramid_flow<event, flow>(
+        128,
+        64,
+        5,
+        1,
+        100,
+        5,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void {
+            ++flows;
+            REQUIRE(std::isfinite(flow.vx));
+            REQUIRE(std::isfinite(flow.vy));
+            if (std::abs(flow.vx - 4.0f) < 1.0f && std::abs(flow.vy) < 1.0f) {
+                ++accurate_flows;
+            }
+        });
+    for (auto event : edge_events(128, 64, 4.0f)) {
+        compute_fine_flow(event);
+        compute_pyramid_flow(event);
+    }
+    REQUIRE(flows > fine_flows);
+    REQUIRE(accurate_flows > flows * 3 / 4);
+}
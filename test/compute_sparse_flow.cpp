@@ -0,0 +1,182 @@
+#include "../source/compute_sparse_flow.hpp"
+#include "../source/compute_flow.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct flow {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        float vx;
+        float vy;
+    };
+}
+
+TEST_CASE("Compute the sparse optical flow from the given events", "[compute_sparse_flow]") {
+    flow expected_flow{
+        2010000,
+        100,
+        100,
+        0.0000904721018f,
+        0.000232017177f,
+    };
+    auto flow_generated = false;
+    auto compute_sparse_flow = tarsier::make_compute_sparse_flow<event, flow>(
+        320,
+        240,
+        2,
+        1000000,
+        10,
+        0.01f,
+        tarsier::flow_mode::normal,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void {
+            flow_generated = true;
+            REQUIRE(flow.t == expected_flow.t);
+            REQUIRE(flow.x == expected_flow.x);
+            REQUIRE(flow.y == expected_flow.y);
+            REQUIRE(std::abs(flow.vx - expected_flow.vx) / expected_flow.vx < 1e-3f);
+            REQUIRE(std::abs(flow.vy - expected_flow.vy) / expected_flow.vy < 1e-3f);
+        });
+    compute_sparse_flow(event{2000000, 100 - 2, 100 - 2});
+    compute_sparse_flow(event{2001000, 100 - 1, 100 - 2});
+    compute_sparse_flow(event{2002000, 100 - 0, 100 - 2});
+    compute_sparse_flow(event{2003000, 100 - 2, 100 - 1});
+    compute_sparse_flow(event{2004000, 100 + 1, 100 - 2});
+    compute_sparse_flow(event{2005000, 100 - 1, 100 - 1});
+    compute_sparse_flow(event{2006000, 100 - 0, 100 - 1});
+    compute_sparse_flow(event{2007000, 100 - 2, 100 - 0});
+    compute_sparse_flow(event{2008000, 100 + 1, 100 - 1});
+    compute_sparse_flow(event{2010000, 100, 100});
+    REQUIRE(flow_generated);
+}
+
+TEST_CASE("Match compute_flow on a moving edge", "[compute_sparse_flow]") {
+    std::vector<event> events;
+    uint32_t state = 1;
+    for (uint64_t step = 0; step < 2000; ++step) {
+        for (uint16_t y = 20; y < 40; ++y) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            const auto x = static_cast<int32_t>(step / 20) + y / 3 + static_cast<int32_t>(state % 3);
+            if (x < 64) {
+                events.push_back(event{1000 + step * 50 + y, static_cast<uint16_t>(x), y});
+            }
+        }
+    }
+    std::vector<flow> expected_flows;
+    auto compute_flow = tarsier::make_compute_flow<event, flow>(
+        64,
+        64,
+        2,
+        5000,
+        8,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void { expected_flows.push_back(flow); });
+    std::vector<flow> flows;
+    auto compute_sparse_flow = tarsier::make_compute_sparse_flow<event, flow>(
+        64,
+        64,
+        2,
+        5000,
+        8,
+        0.0f,
+        tarsier::flow_mode::normal,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void { flows.push_back(flow); });
+    for (auto event : events) {
+        compute_flow(event);
+        compute_sparse_flow(event);
+    }
+    REQUIRE(flows.size() > 1000);
+    auto index = std::size_t(0);
+    for (auto expected_flow : expected_flows) {
+        if (!std::isfinite(expected_flow.vx) || !std::isfinite(expected_flow.vy)) {
+            continue;
+        }
+        while (index < flows.size() && flows[index].t < expected_flow.t) {
+            ++index;
+        }
+        REQUIRE(index < flows.size());
+        REQUIRE(flows[index].t == expected_flow.t);
+        const auto norm = std::hypot(expected_flow.vx, expected_flow.vy);
+        REQUIRE(std::abs(flows[index].vx - expected_flow.vx) < 1e-2f * norm);
+        REQUIRE(std::abs(flows[index].vy - expected_flow.vy) < 1e-2f * norm);
+    }
+}
+
+TEST_CASE("Reject degenerate fits", "[compute_sparse_flow]") {
+    auto flows = 0;
+    auto compute_sparse_flow = tarsier::make_compute_sparse_flow<event, flow>(
+        320,
+        240,
+        2,
+        1000000,
+        3,
+        0.1f,
+        tarsier::flow_mode::normal,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow) -> void { ++flows; });
+    for (uint16_t x = 98; x <= 102; ++x) {
+        compute_sparse_flow(event{2000000 + x * 1000ull, x, 100});
+    }
+    for (uint16_t y = 98; y <= 102; ++y) {
+        compute_sparse_flow(event{3000000, 50, y});
+        compute_sparse_flow(event{3000000, 51, y});
+    }
+    REQUIRE(flows == 0);
+}
+
+TEST_CASE("Combine normal flows into a full flow", "[compute_sparse_flow]") {
+    // a corner moves along x: the vertical edge's normal flow is (v, 0), the diagonal edge's is (v / 2, v / 2)
+    // only the events near the corner see both orientations
+    std::vector<event> events;
+    for (uint16_t y = 0; y < 40; ++y) {
+        for (uint16_t x = 0; x < 40; ++x) {
+            events.push_back(event{static_cast<uint64_t>(y < 20 ? x * 1000 : (x + y - 20) * 1000), x, y});
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](event first, event second) { return first.t < second.t; });
+    std::vector<flow> flows;
+    auto compute_sparse_flow = tarsier::make_compute_sparse_flow<event, flow>(
+        40,
+        40,
+        3,
+        8000,
+        8,
+        0.02f,
+        tarsier::flow_mode::full,
+        [](event event, float vx, float vy) -> flow {
+            return {event.t, event.x, event.y, vx, vy};
+        },
+        [&](flow flow) -> void { flows.push_back(flow); });
+    for (auto event : events) {
+        compute_sparse_flow(event);
+    }
+    auto matches = 0;
+    for (auto flow : flows) {
+        REQUIRE(flow.y >= 14);
+        REQUIRE(flow.y <= 26);
+        REQUIRE(flow.vx > 5e-4f);
+        REQUIRE(flow.vx < 1.5e-3f);
+        if (std::abs(flow.vx - 1e-3f) < 1.5e-4f && std::abs(flow.vy) < 1.5e-4f) {
+            ++matches;
+        }
+    }
+    REQUIRE(matches > 40);
+}
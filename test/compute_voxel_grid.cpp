@@ -0,0 +1,83 @@
+#include "../source/compute_voxel_grid.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        bool polarity;
+    };
+}
+
+TEST_CASE("Compute voxel grids over time windows", "[compute_voxel_grid]") {
+    std::vector<std::vector<float>> grids;
+    auto compute_voxel_grid = tarsier::make_compute_voxel_grid<event>(
+        4,
+        3,
+        3,
+        100,
+        1,
+        [&](tarsier::voxel_grid_view voxel_grid) -> void {
+            REQUIRE(reinterpret_cast<std::uintptr_t>(voxel_grid.values) % 64 == 0);
+            REQUIRE(voxel_grid.begin_t == 10 + 100 * grids.size());
+            grids.push_back({voxel_grid.at(0, 1, 2), voxel_grid.at(1, 1, 2), voxel_grid.at(2, 1, 2)});
+        });
+    // the window [10, 110[ is mapped onto [0, 2], hence t = 35 falls halfway between the first two bins
+    compute_voxel_grid(event{10, 1, 2, true});
+    compute_voxel_grid(event{35, 1, 2, false});
+    compute_voxel_grid(event{85, 1, 2, true});
+    REQUIRE(grids.empty());
+    compute_voxel_grid(event{110, 1, 2, true});
+    REQUIRE(grids.size() == 1);
+    REQUIRE(std::abs(grids[0][0] - 0.5f) < 1e-5f);
+    REQUIRE(std::abs(grids[0][1] - (-0.5f + 0.5f)) < 1e-5f);
+    REQUIRE(std::abs(grids[0][2] - 0.5f) < 1e-5f);
+    compute_voxel_grid(event{210, 1, 2, true});
+    REQUIRE(grids.size() == 2);
+    REQUIRE(grids[1] == std::vector<float>({1.0f, 0.0f, 0.0f}));
+}
+
+TEST_CASE("Compute voxel grids from batches in parallel", "[compute_voxel_grid]") {
+    std::vector<event> events;
+    std::mt19937 engine(7);
+    std::uniform_int_distribution<uint16_t> x_distribution(0, 31);
+    std::uniform_int_distribution<uint16_t> y_distribution(0, 23);
+    std::uniform_int_distribution<uint16_t> polarity_distribution(0, 1);
+    for (uint64_t t = 1000; t < 21000; t += 2) {
+        events.push_back(event{t, x_distribution(engine), y_distribution(engine), polarity_distribution(engine) == 1});
+    }
+    std::vector<std::vector<float>> grids;
+    for (std::size_t threads = 1; threads <= 8; threads *= 2) {
+        auto compute_voxel_grid = tarsier::make_compute_voxel_grid<event>(
+            32,
+            24,
+            5,
+            1,
+            threads,
+            [&](tarsier::voxel_grid_view voxel_grid) -> void {
+                REQUIRE(voxel_grid.begin_t == 1000);
+                REQUIRE(voxel_grid.end_t == 20998);
+                grids.emplace_back(voxel_grid.values, voxel_grid.values + 5 * 24 * 32);
+            });
+        compute_voxel_grid(events.data(), events.data() + events.size());
+        // the storage is reused for the next batch
+        compute_voxel_grid(events.data(), events.data() + events.size());
+    }
+    REQUIRE(grids.size() == 8);
+    for (const auto& grid : grids) {
+        REQUIRE(grid == grids.front());
+    }
+    // each event contributes its polarity to the grid
+    float sum = 0.0f;
+    float expected_sum = 0.0f;
+    for (std::size_t index = 0; index < grids.front().size(); ++index) {
+        sum += grids.front()[index];
+    }
+    for (const auto& event : events) {
+        expected_sum += event.polarity ? 1.0f : -1.0f;
+    }
+    REQUIRE(std::abs(sum - expected_sum) < 1e-1f);
+}
@@ -0,0 +1,62 @@
+#include "../source/detect_corners.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        bool polarity;
+    };
+}
+
+TEST_CASE("Detect a corner with an arc test", "[detect_corners]") {
+    std::vector<event> corners;
+    auto detect_corners = tarsier::make_detect_corners<event, 3, 4>(
+        40, 30, [&](event event) -> void { corners.push_back(event); });
+    // an edge sweeps the lower-right quadrant of the pixel (20, 15) first, hence the most recent timestamps form
+    // an arc on both circles
+    for (uint16_t y = 10; y <= 20; ++y) {
+        for (uint16_t x = 15; x <= 25; ++x) {
+            if (x != 20 || y != 15) {
+                detect_corners(event{static_cast<uint64_t>(x >= 20 && y >= 15 ? 100 : 10), x, y, true});
+            }
+        }
+    }
+    corners.clear();
+    detect_corners(event{200, 20, 15, true});
+    REQUIRE(corners.size() == 1);
+    REQUIRE(corners[0].t == 200);
+
+    // the other polarity has its own surface, where the same event is not a corner
+    detect_corners(event{200, 20, 15, false});
+    REQUIRE(corners.size() == 1);
+
+    // events close to the border are not corners
+    detect_corners(event{300, 3, 15, true});
+    REQUIRE(corners.size() == 1);
+}
+
+TEST_CASE("Ignore edges and uniform surfaces", "[detect_corners]") {
+    std::vector<event> corners;
+    auto detect_corners = tarsier::make_detect_corners<event, 4, 5>(
+        40, 30, [&](event event) -> void { corners.push_back(event); });
+    // the most recent half of the surface (an edge) makes arcs longer than the allowed range
+    for (uint16_t y = 5; y <= 25; ++y) {
+        for (uint16_t x = 10; x <= 30; ++x) {
+            detect_corners(event{static_cast<uint64_t>(x >= 20 ? 100 : 10), x, y, false});
+        }
+    }
+    corners.clear();
+    detect_corners(event{200, 20, 15, false});
+    REQUIRE(corners.empty());
+    for (uint16_t y = 5; y <= 25; ++y) {
+        for (uint16_t x = 10; x <= 30; ++x) {
+            detect_corners(event{300, x, y, false});
+        }
+    }
+    corners.clear();
+    detect_corners(event{400, 20, 15, false});
+    REQUIRE(corners.empty());
+}
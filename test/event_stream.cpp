@@ -0,0 +1,128 @@
+#include "../source/event_stream.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        bool polarity;
+    };
+}
+
+TEST_CASE("Write and read an event stream", "[event_stream]") {
+    const std::string filename("tarsier_event_stream_test.es");
+    std::vector<event> events;
+    for (uint64_t index = 0; index < 1000; ++index) {
+        events.push_back(event{
+            index * index,
+            static_cast<uint16_t>((index * 7) % 640),
+            static_cast<uint16_t>((index * 13) % 480),
+            index % 3 == 0,
+        });
+    }
+    {
+        auto write_stream = tarsier::make_write_stream<event>(filename, 640, 480, 64);
+        for (auto event : events) {
+            write_stream(event);
+        }
+    }
+    {
+        auto read_stream = tarsier::make_read_stream<event>(filename);
+        REQUIRE(read_stream.width() == 640);
+        REQUIRE(read_stream.height() == 480);
+        REQUIRE(read_stream.number_of_events() == events.size());
+        std::size_t index = 0;
+        read_stream.read([&](event event) {
+            REQUIRE(event.t == events[index].t);
+            REQUIRE(event.x == events[index].x);
+            REQUIRE(event.y == events[index].y);
+            REQUIRE(event.polarity == events[index].polarity);
+            ++index;
+        });
+        REQUIRE(index == events.size());
+        read_stream.seek(500 * 500 - 1);
+        index = 500;
+        read_stream.read([&](event event) {
+            REQUIRE(event.t == events[index].t);
+            ++index;
+        });
+        REQUIRE(index == events.size());
+    }
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Reject events outside of the sensor", "[event_stream]") {
+    const std::string filename("tarsier_event_stream_range_test.es");
+    {
+        auto write_stream = tarsier::make_write_stream<event>(filename, 640, 480, 16);
+        write_stream(event{0, 639, 479, true});
+        REQUIRE_THROWS_AS(write_stream(event{1, 640, 0, false}), std::logic_error);
+        REQUIRE_THROWS_AS(write_stream(event{2, 0, 480, false}), std::logic_error);
+    }
+    {
+        auto read_stream = tarsier::make_read_stream<event>(filename);
+        REQUIRE(read_stream.number_of_events() == 1);
+        read_stream.read([](event event) {
+            REQUIRE(event.x == 639);
+            REQUIRE(event.y == 479);
+            REQUIRE(event.polarity);
+        });
+    }
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Reject a corrupted event stream", "[event_stream]") {
+    const std::string filename("tarsier_event_stream_corrupted_test.es");
+    {
+        auto write_stream = tarsier::make_write_stream<event>(filename, 640, 480, 16);
+        for (uint64_t index = 0; index < 100; ++index) {
+            write_stream(event{index * 1000, static_cast<uint16_t>(index), static_cast<uint16_t>(index), true});
+        }
+    }
+    std::vector<uint8_t> bytes;
+    {
+        std::ifstream file(filename, std::ifstream::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    const auto footer = bytes.size() - tarsier::event_stream_format::footer_size;
+    const auto index_offset = tarsier::event_stream_format::read_integer<uint64_t>(bytes.data() + footer);
+    const auto write_corrupted = [&](const std::vector<uint8_t>& corrupted_bytes) {
+        std::ofstream file(filename, std::ofstream::binary);
+        file.write(reinterpret_cast<const char*>(corrupted_bytes.data()), corrupted_bytes.size());
+    };
+    SECTION("a number of blocks whose index size overflows") {
+        auto corrupted_bytes = bytes;
+        tarsier::event_stream_format::write_integer<uint64_t>(
+            corrupted_bytes.data() + footer + 8, (static_cast<uint64_t>(1) << 59) + 7);
+        write_corrupted(corrupted_bytes);
+        REQUIRE_THROWS_AS(tarsier::make_read_stream<event>(filename), std::runtime_error);
+    }
+    SECTION("a block offset beyond the index") {
+        auto corrupted_bytes = bytes;
+        tarsier::event_stream_format::write_integer<uint64_t>(
+            corrupted_bytes.data() + index_offset + 16, index_offset - 8);
+        write_corrupted(corrupted_bytes);
+        REQUIRE_THROWS_AS(tarsier::make_read_stream<event>(filename), std::runtime_error);
+    }
+    SECTION("a timestamp that does not end in its block") {
+        auto corrupted_bytes = bytes;
+        const auto payload = corrupted_bytes.begin() + tarsier::event_stream_format::header_size
+                             + tarsier::event_stream_format::block_header_size;
+        std::fill(
+            payload,
+            payload
+                + tarsier::event_stream_format::read_integer<uint32_t>(
+                    bytes.data() + tarsier::event_stream_format::header_size + 12),
+            0xff);
+        write_corrupted(corrupted_bytes);
+        auto read_stream = tarsier::make_read_stream<event>(filename);
+        REQUIRE_THROWS_AS(read_stream.read([](event) {}), std::runtime_error);
+    }
+    std::remove(filename.c_str());
+}
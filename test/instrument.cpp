@@ -0,0 +1,53 @@
+#include "../source/instrument.hpp"
+#include "../source/mask_isolated.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <type_traits>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+}
+
+TEST_CASE("Count and time the events of an instrumented stage", "[instrument]") {
+    tarsier::basic_probe<true> probe(1);
+    std::size_t count = 0;
+    auto pipeline = tarsier::instrument(probe, tarsier::make_stage<tarsier::mask_isolated, event>(320, 240, 10))
+                    | [&](event) { ++count; };
+    pipeline(event{0, 200, 200});
+    pipeline(event{1, 200, 202});
+    pipeline(event{20, 200, 201});
+    pipeline(event{40, 100, 100});
+    pipeline(event{41, 100, 101});
+    const auto snapshot = probe.snapshot();
+    REQUIRE(snapshot.events_in == 5);
+    REQUIRE(snapshot.events_out == 1);
+    REQUIRE(snapshot.events_out == count);
+    REQUIRE(snapshot.samples() == 5);
+    REQUIRE(snapshot.quantile(0.5) <= snapshot.quantile(0.99));
+}
+
+TEST_CASE("Map latencies to log-linear buckets", "[instrument]") {
+    for (uint64_t latency : {0ull, 7ull, 8ull, 15ull, 16ull, 1000ull, 123456789ull}) {
+        const auto bucket = tarsier::probe_snapshot::bucket(latency);
+        REQUIRE(tarsier::probe_snapshot::lower_bound(bucket) <= latency);
+        REQUIRE(tarsier::probe_snapshot::lower_bound(bucket + 1) > latency);
+    }
+}
+
+TEST_CASE("Disable a probe at compile time", "[instrument]") {
+    tarsier::basic_probe<false> probe;
+    std::size_t count = 0;
+    auto probe_input = tarsier::make_probe_input<event>(
+        probe, tarsier::make_mask_isolated<event>(320, 240, 10, tarsier::make_probe_output(probe, [&](event) {
+                                                      ++count;
+                                                  })));
+    probe_input(event{40, 100, 100});
+    probe_input(event{41, 100, 101});
+    REQUIRE(count == 1);
+    REQUIRE(probe.snapshot().events_in == 0);
+    REQUIRE(probe.snapshot().samples() == 0);
+    REQUIRE(std::is_empty<tarsier::basic_probe<false>>::value);
+}
@@ -1,9 +1,21 @@
 #include "../source/merge.hpp"
 #include "../third_party/Catch2/single_include/catch.hpp"
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
 
-struct event {
-    uint64_t t;
-};
+namespace {
+    struct event {
+        uint64_t t;
+    };
+
+    struct producer_event {
+        uint64_t t;
+        uint16_t producer;
+        uint64_t index;
+    };
+}
 
 TEST_CASE("Merge two streams", "[merge]") {
     std::size_t index = 0;
@@ -14,3 +26,204 @@ TEST_CASE("Merge two streams", "[merge]") {
     merge->push<0>(event{1});
     merge->push<1>(event{0});
 }
+
+TEST_CASE("Merge concurrent pushes to a single source", "[merge]") {
+    const std::size_t producers = 4;
+    const uint64_t events_per_producer = 20000;
+    std::vector<uint64_t> next_indices(producers, 0);
+    auto ordered = true;
+    {
+        auto merge = tarsier::make_merge<1, producer_event>(
+            64, std::chrono::microseconds(10), [&](producer_event event) -> void {
+                if (event.index != next_indices[event.producer]) {
+                    ordered = false;
+                }
+                ++next_indices[event.producer];
+            });
+        std::vector<std::thread> threads;
+        for (uint16_t producer = 0; producer < producers; ++producer) {
+            threads.emplace_back([&, producer]() {
+                for (uint64_t index = 0; index < events_per_producer; ++index) {
+                    while (!merge->push_concurrent<0>(producer_event{index, producer, index})) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    REQUIRE(ordered);
+    for (auto next_index : next_indices) {
+        REQUIRE(next_index == events_per_producer);
+    }
+}
+
+// push_while_blocked pushes ten events to a single-source merge, whose handler blocks on the first event
+// until the pushes are done. It waits for the dispatch of expected_handled events before reading the counters.
+static void push_while_blocked(
+    tarsier::overflow_policy policy,
+    std::size_t expected_handled,
+    std::vector<bool>& results,
+    std::vector<uint64_t>& ts,
+    tarsier::merge_counters& counters) {
+    std::atomic_bool entered(false);
+    std::atomic_bool released(false);
+    std::atomic<std::size_t> handled(0);
+    auto merge = tarsier::make_merge<1, event>(
+        4,
+        std::chrono::microseconds(10),
+        std::array<tarsier::overflow_policy, 1>{{policy}},
+        [&](event event) -> void {
+            if (event.t == 0) {
+                entered.store(true, std::memory_order_release);
+                while (!released.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+            }
+            ts.push_back(event.t);
+            handled.fetch_add(1, std::memory_order_release);
+        });
+    results.push_back(merge->push<0>(event{0}));
+    while (!entered.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    for (uint64_t t = 1; t < 10; ++t) {
+        results.push_back(merge->push<0>(event{t}));
+    }
+    released.store(true, std::memory_order_release);
+    while (handled.load(std::memory_order_acquire) < expected_handled) {
+        std::this_thread::yield();
+    }
+    counters = merge->counters(0);
+}
+
+TEST_CASE("Merge rejects events when the fifo is full", "[merge]") {
+    std::vector<bool> results;
+    std::vector<uint64_t> ts;
+    tarsier::merge_counters counters;
+    push_while_blocked(
+        tarsier::overflow_policy{tarsier::overflow::reject, std::chrono::high_resolution_clock::duration(0), 0},
+        5,
+        results,
+        ts,
+        counters);
+    REQUIRE(results == std::vector<bool>({true, true, true, true, true, false, false, false, false, false}));
+    REQUIRE(ts == std::vector<uint64_t>({0, 1, 2, 3, 4}));
+    REQUIRE(counters.pushes == 5);
+    REQUIRE(counters.drops == 0);
+    REQUIRE(counters.rejections == 5);
+    REQUIRE(counters.high_water_mark == 4);
+}
+
+TEST_CASE("Merge drops the newest events when the fifo is full", "[merge]") {
+    std::vector<bool> results;
+    std::vector<uint64_t> ts;
+    tarsier::merge_counters counters;
+    push_while_blocked(
+        tarsier::overflow_policy{tarsier::overflow::drop_newest, std::chrono::high_resolution_clock::duration(0), 0},
+        5,
+        results,
+        ts,
+        counters);
+    REQUIRE(ts == std::vector<uint64_t>({0, 1, 2, 3, 4}));
+    REQUIRE(counters.pushes == 5);
+    REQUIRE(counters.drops == 5);
+    REQUIRE(counters.rejections == 0);
+}
+
+TEST_CASE("Merge drops the oldest events when the fifo is full", "[merge]") {
+    std::vector<bool> results;
+    std::vector<uint64_t> ts;
+    tarsier::merge_counters counters;
+    push_while_blocked(
+        tarsier::overflow_policy{tarsier::overflow::drop_oldest, std::chrono::high_resolution_clock::duration(0), 0},
+        5,
+        results,
+        ts,
+        counters);
+    REQUIRE(results == std::vector<bool>(10, true));
+    REQUIRE(ts == std::vector<uint64_t>({0, 6, 7, 8, 9}));
+    REQUIRE(counters.pushes == 10);
+    REQUIRE(counters.drops == 5);
+    REQUIRE(counters.high_water_mark == 4);
+}
+
+TEST_CASE("Merge spills events when the fifo is full", "[merge]") {
+    std::vector<bool> results;
+    std::vector<uint64_t> ts;
+    tarsier::merge_counters counters;
+    push_while_blocked(
+        tarsier::overflow_policy{tarsier::overflow::spill, std::chrono::high_resolution_clock::duration(0), 3},
+        8,
+        results,
+        ts,
+        counters);
+    REQUIRE(results == std::vector<bool>({true, true, true, true, true, true, true, true, false, false}));
+    REQUIRE(ts == std::vector<uint64_t>({0, 1, 2, 3, 4, 5, 6, 7}));
+    REQUIRE(counters.pushes == 8);
+    REQUIRE(counters.drops == 2);
+    REQUIRE(counters.spill_high_water_mark == 3);
+}
+
+TEST_CASE("Merge blocks until the fifo has room", "[merge]") {
+    std::atomic_bool released(false);
+    std::vector<uint64_t> ts;
+    {
+        auto merge = tarsier::make_merge<1, event>(
+            2,
+            std::chrono::microseconds(10),
+            std::array<tarsier::overflow_policy, 1>{
+                {tarsier::overflow_policy{tarsier::overflow::block, std::chrono::milliseconds(20), 0}}},
+            [&](event event) -> void {
+                while (!released.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                ts.push_back(event.t);
+            });
+        // the handler holds the first event, and the fifo holds the next two
+        REQUIRE(merge->push<0>(event{0}));
+        while (merge->counters(0).high_water_mark == 0) {
+            std::this_thread::yield();
+        }
+        REQUIRE(merge->push<0>(event{1}));
+        REQUIRE(merge->push<0>(event{2}));
+        REQUIRE(!merge->push<0>(event{3}));
+        REQUIRE(merge->counters(0).drops == 1);
+        std::thread release([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            released.store(true, std::memory_order_release);
+        });
+        REQUIRE(merge->push<0>(event{4}));
+        release.join();
+    }
+    REQUIRE(ts == std::vector<uint64_t>({0, 1, 2, 4}));
+}
+
+TEST_CASE("Merge reports the dispatch placement", "[merge]") {
+    std::vector<uint64_t> ts;
+    {
+        auto merge = tarsier::make_merge<2, event>(
+            16,
+            std::chrono::microseconds(10),
+            std::array<tarsier::overflow_policy, 2>{{
+                tarsier::overflow_policy{tarsier::overflow::reject, std::chrono::high_resolution_clock::duration(0), 0},
+                tarsier::overflow_policy{tarsier::overflow::reject, std::chrono::high_resolution_clock::duration(0), 0},
+            }},
+            tarsier::dispatch_placement{0, 0, true},
+            [&](event event) -> void { ts.push_back(event.t); });
+        const auto report = merge->placement();
+        REQUIRE(!report.priority_applied);
+        REQUIRE(report.fifo_nodes.size() == 2);
+#ifdef __linux__
+        // the first core may be outside the process' cpuset, in which case pinning fails
+        if (report.affinity_applied) {
+            REQUIRE(report.cpu == 0);
+        }
+#endif
+        REQUIRE(merge->push<0>(event{1}));
+        REQUIRE(merge->push<1>(event{0}));
+    }
+    REQUIRE(ts == std::vector<uint64_t>({0, 1}));
+}
@@ -9,3 +9,8 @@ TEST_CASE("Invert the x coordinate", "[mirror_x]") {
     auto mirror_x = tarsier::make_mirror_x<event>(320, [](event event) -> void { REQUIRE(event.x == 100); });
     mirror_x(event{219});
 }
+
+TEST_CASE("Invert the x coordinate with a compile-time geometry", "[mirror_x]") {
+    auto mirror_x = tarsier::make_mirror_x<event, 320>([](event event) -> void { REQUIRE(event.x == 100); });
+    mirror_x(event{219});
+}
@@ -9,3 +9,8 @@ TEST_CASE("Invert the y coordinate", "[mirror_y]") {
     auto mirror_y = tarsier::make_mirror_y<event>(240, [](event event) -> void { REQUIRE(event.y == 100); });
     mirror_y(event{139});
 }
+
+TEST_CASE("Invert the y coordinate with a compile-time geometry", "[mirror_y]") {
+    auto mirror_y = tarsier::make_mirror_y<event, 240>([](event event) -> void { REQUIRE(event.y == 100); });
+    mirror_y(event{139});
+}
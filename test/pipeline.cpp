@@ -0,0 +1,78 @@
+#include "../source/compute_activity.hpp"
+#include "../source/convert.hpp"
+#include "../source/mask_isolated.hpp"
+#include "../source/pipeline.hpp"
+#include "../source/select_rectangle.hpp"
+#include "../source/shift_x.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct activity {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        float potential;
+    };
+
+    struct converted_activity {
+        uint16_t x;
+        float potential;
+    };
+}
+
+TEST_CASE("Compose handlers into a pipeline", "[pipeline]") {
+    std::vector<converted_activity> expected_converted_activities;
+    auto convert = tarsier::make_convert<activity>(
+        [](activity activity) -> converted_activity {
+            return {activity.x, activity.potential};
+        },
+        [&](converted_activity converted_activity) { expected_converted_activities.push_back(converted_activity); });
+    auto compute_activity = tarsier::make_compute_activity<event, activity>(
+        320,
+        240,
+        10000,
+        [](event event, float potential) -> activity {
+            return {event.t, event.x, event.y, potential};
+        },
+        [&](activity activity) { convert(activity); });
+    auto shift_x = tarsier::make_shift_x<event>(320, -50, [&](event event) { compute_activity(event); });
+    auto select_rectangle =
+        tarsier::make_select_rectangle<event>(50, 50, 100, 100, [&](event event) { shift_x(event); });
+    auto mask_isolated =
+        tarsier::make_mask_isolated<event>(320, 240, 10, [&](event event) { select_rectangle(event); });
+    std::vector<converted_activity> converted_activities;
+    auto pipeline = tarsier::make_stage<tarsier::mask_isolated, event>(320, 240, 10)
+                    | tarsier::make_stage<tarsier::select_rectangle, event>(50, 50, 100, 100)
+                    | tarsier::make_stage<tarsier::shift_x, event>(320, -50)
+                    | tarsier::make_stage<tarsier::compute_activity, event, activity>(
+                          320,
+                          240,
+                          10000,
+                          [](event event, float potential) -> activity {
+                              return {event.t, event.x, event.y, potential};
+                          })
+                    | tarsier::make_stage<tarsier::convert, activity>([](activity activity) -> converted_activity {
+                          return {activity.x, activity.potential};
+                      })
+                    | [&](converted_activity converted_activity) {
+                          converted_activities.push_back(converted_activity);
+                      };
+    std::vector<event> events{
+        {0, 200, 200}, {1, 200, 202}, {20, 200, 201}, {40, 100, 100}, {41, 100, 101}, {45, 100, 100}, {46, 20, 20}};
+    for (auto event : events) {
+        mask_isolated(event);
+    }
+    pipeline(events.begin(), events.end());
+    REQUIRE(expected_converted_activities.size() == 2);
+    REQUIRE(converted_activities.size() == expected_converted_activities.size());
+    for (std::size_t index = 0; index < converted_activities.size(); ++index) {
+        REQUIRE(converted_activities[index].x == 50);
+        REQUIRE(converted_activities[index].potential == expected_converted_activities[index].potential);
+    }
+}
@@ -0,0 +1,102 @@
+#include "../source/mask_isolated.hpp"
+#include "../source/process_chunks.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <cstdio>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        bool polarity;
+    };
+}
+
+TEST_CASE("Process chunks of a vector in parallel", "[process_chunks]") {
+    std::vector<event> events;
+    uint32_t state = 1;
+    for (uint64_t t = 0; t < 200000; t += 7) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        events.push_back(
+            event{t, static_cast<uint16_t>(state % 16), static_cast<uint16_t>((state >> 8) % 16), false});
+    }
+    std::vector<event> expected_events;
+    auto mask_isolated = tarsier::make_mask_isolated<event>(
+        16, 16, 300, [&](event event) { expected_events.push_back(event); });
+    for (auto event : events) {
+        mask_isolated(event);
+    }
+    REQUIRE(expected_events.size() > 1000);
+    REQUIRE(expected_events.size() < events.size());
+    std::vector<event> chunked_events;
+    tarsier::process_chunks<event>(
+        events,
+        10000,
+        300,
+        4,
+        [](tarsier::chunk_output<event> output) {
+            return tarsier::make_mask_isolated<event>(16, 16, 300, std::move(output));
+        },
+        [&](event event) { chunked_events.push_back(event); });
+    REQUIRE(chunked_events.size() == expected_events.size());
+    for (std::size_t index = 0; index < chunked_events.size(); ++index) {
+        REQUIRE(chunked_events[index].t == expected_events[index].t);
+        REQUIRE(chunked_events[index].x == expected_events[index].x);
+        REQUIRE(chunked_events[index].y == expected_events[index].y);
+    }
+}
+
+TEST_CASE("Process chunks of a stream file in parallel", "[process_chunks]") {
+    const std::string filename("tarsier_process_chunks_test.es");
+    {
+        auto write_stream = tarsier::make_write_stream<event>(filename, 640, 480, 64);
+        for (uint64_t index = 0; index < 10000; ++index) {
+            write_stream(
+                event{index * 3, static_cast<uint16_t>(index % 640), static_cast<uint16_t>(index % 480), true});
+        }
+    }
+    uint64_t previous_t = 0;
+    std::size_t count = 0;
+    tarsier::process_chunks<uint64_t, event>(
+        filename,
+        1000,
+        0,
+        3,
+        [](tarsier::chunk_output<uint64_t> output) {
+            return [output](event event) mutable { output(event.t); };
+        },
+        [&](uint64_t t) {
+            if (count > 0) {
+                REQUIRE(t == previous_t + 3);
+            }
+            previous_t = t;
+            ++count;
+        });
+    REQUIRE(count == 10000);
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Rethrow the exceptions of chunks", "[process_chunks]") {
+    std::vector<event> events;
+    for (uint64_t t = 0; t < 100000; t += 10) {
+        events.push_back(event{t, 0, 0, false});
+    }
+    REQUIRE_THROWS_AS(
+        tarsier::process_chunks<uint64_t>(
+            events,
+            1000,
+            0,
+            2,
+            [](tarsier::chunk_output<uint64_t> output) {
+                return [output](event event) mutable {
+                    if (event.t == 55550) {
+                        throw std::runtime_error("chunk error");
+                    }
+                    output(event.t);
+                };
+            },
+            [](uint64_t) {}),
+        std::runtime_error);
+}
@@ -0,0 +1,93 @@
+#include "../source/replay.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+        bool polarity;
+    };
+}
+
+TEST_CASE("Replay a stream at real-time speed", "[replay]") {
+    const std::string filename("tarsier_replay_test.es");
+    {
+        auto write_stream = tarsier::make_write_stream<event>(filename, 320, 240, 8);
+        for (uint64_t t = 0; t < 20; ++t) {
+            write_stream(event{1000 + t * 1000, static_cast<uint16_t>(t), 0, true});
+        }
+    }
+    {
+        std::vector<uint64_t> ts;
+        auto begin = std::chrono::steady_clock::now();
+        auto replay = tarsier::make_replay(
+            tarsier::make_read_stream<event>(filename), 1.0, 4, [&](event event) { ts.push_back(event.t); });
+        replay->wait();
+        const auto duration = std::chrono::steady_clock::now() - begin;
+        const auto statistics = replay->statistics();
+        REQUIRE(statistics.finished);
+        REQUIRE(statistics.events == 20);
+        REQUIRE(statistics.dropped == 0);
+        REQUIRE(duration >= std::chrono::microseconds(19000));
+        REQUIRE(statistics.elapsed >= std::chrono::microseconds(19000));
+        REQUIRE(ts.size() == 20);
+        for (uint64_t t = 0; t < 20; ++t) {
+            REQUIRE(ts[t] == 1000 + t * 1000);
+        }
+    }
+    {
+        std::size_t count = 0;
+        auto replay = tarsier::make_replay(tarsier::make_read_stream<event>(filename), 0.0, 4, [&](event) -> bool {
+            ++count;
+            return count % 2 == 0;
+        });
+        replay->wait();
+        const auto statistics = replay->statistics();
+        REQUIRE(statistics.events == 20);
+        REQUIRE(statistics.dropped == 10);
+    }
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("Report a corrupted block from the replay's decoder", "[replay]") {
+    const std::string filename("tarsier_replay_corrupted_test.es");
+    {
+        auto write_stream = tarsier::make_write_stream<event>(filename, 320, 240, 8);
+        for (uint64_t t = 0; t < 20; ++t) {
+            write_stream(event{1000 + t * 1000, static_cast<uint16_t>(t), 0, true});
+        }
+    }
+    {
+        std::vector<uint8_t> bytes;
+        {
+            std::ifstream file(filename, std::ifstream::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        // the timestamps of the second block never end
+        const auto second_block = tarsier::event_stream_format::header_size
+                                  + tarsier::event_stream_format::block_header_size
+                                  + tarsier::event_stream_format::read_integer<uint32_t>(
+                                      bytes.data() + tarsier::event_stream_format::header_size + 12);
+        const auto payload = bytes.begin() + second_block + tarsier::event_stream_format::block_header_size;
+        std::fill(
+            payload,
+            payload + tarsier::event_stream_format::read_integer<uint32_t>(bytes.data() + second_block + 12),
+            0xff);
+        std::ofstream file(filename, std::ofstream::binary);
+        file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    {
+        std::size_t count = 0;
+        auto replay =
+            tarsier::make_replay(tarsier::make_read_stream<event>(filename), 0.0, 4, [&](event) { ++count; });
+        REQUIRE_THROWS_AS(replay->wait(), std::runtime_error);
+        REQUIRE(count == 8);
+    }
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,48 @@
+#include "../source/replicate_parallel.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+namespace {
+    struct event {
+        uint64_t t;
+    };
+}
+
+TEST_CASE("Replicate an event and trigger several callbacks on separate threads", "[replicate_parallel]") {
+    std::vector<uint64_t> first_ts;
+    std::vector<uint64_t> second_ts;
+    {
+        auto replicate_parallel = tarsier::make_replicate_parallel<event>(
+            16,
+            std::chrono::microseconds(100),
+            tarsier::backpressure::block,
+            [&](event event) { first_ts.push_back(event.t); },
+            [&](event event) {
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+                second_ts.push_back(event.t);
+            });
+        for (uint64_t t = 0; t < 1000; ++t) {
+            (*replicate_parallel)(event{t});
+        }
+    }
+    REQUIRE(first_ts.size() == 1000);
+    REQUIRE(second_ts.size() == 1000);
+    for (uint64_t t = 0; t < 1000; ++t) {
+        REQUIRE(first_ts[t] == t);
+        REQUIRE(second_ts[t] == t);
+    }
+}
+
+TEST_CASE("Count the events dropped by a slow branch", "[replicate_parallel]") {
+    std::size_t count = 0;
+    std::size_t dropped = 0;
+    {
+        auto replicate_parallel = tarsier::make_replicate_parallel<event>(
+            4, std::chrono::milliseconds(20), tarsier::backpressure::count, [&](event) { ++count; });
+        for (uint64_t t = 0; t < 100; ++t) {
+            (*replicate_parallel)(event{t});
+        }
+        dropped = replicate_parallel->dropped(0);
+    }
+    REQUIRE(dropped > 0);
+    REQUIRE(count + dropped == 100);
+}
@@ -12,3 +12,11 @@ TEST_CASE("Filter out events outside the disk", "[select_disk]") {
     select_disk(event{200, 200});
     select_disk(event{100, 110});
 }
+
+TEST_CASE("Filter out events outside the compile-time disk", "[select_disk]") {
+    auto select_disk =
+        tarsier::make_select_disk<event, 100, 100, 20>([](event event) -> void { REQUIRE(event.x == 100); });
+    select_disk(event{200, 200});
+    select_disk(event{0, 0});
+    select_disk(event{100, 110});
+}
@@ -12,3 +12,11 @@ TEST_CASE("Filter out events outside the rectangle", "[select_rectangle]") {
     select_rectangle(event{300, 200});
     select_rectangle(event{100, 100});
 }
+
+TEST_CASE("Filter out events outside the compile-time rectangle", "[select_rectangle]") {
+    auto select_rectangle = tarsier::make_select_rectangle<event, 50, 50, 204, 140>(
+        [](event event) -> void { REQUIRE(event.x == 100); });
+    select_rectangle(event{300, 200});
+    select_rectangle(event{10, 100});
+    select_rectangle(event{100, 100});
+}
@@ -0,0 +1,52 @@
+#include "../source/select_regions.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
+
+namespace {
+    struct event {
+        uint16_t x;
+        uint16_t y;
+    };
+}
+
+TEST_CASE("Dispatch events to the regions they belong to", "[select_regions]") {
+    std::vector<std::size_t> regions;
+    auto select_regions = tarsier::make_select_regions<event>(
+        320,
+        240,
+        {tarsier::region::rectangle(50, 50, 100, 100),
+         tarsier::region::disk(100, 100, 20),
+         tarsier::region::polygon({{200, 10}, {300, 10}, {250, 110}})},
+        [&](event, std::size_t region) { regions.push_back(region); });
+    select_regions(event{0, 0});
+    REQUIRE(regions.empty());
+    select_regions(event{100, 110});
+    REQUIRE(regions == std::vector<std::size_t>{0, 1});
+    regions.clear();
+    select_regions(event{60, 60});
+    REQUIRE(regions == std::vector<std::size_t>{0});
+    regions.clear();
+    select_regions(event{250, 50});
+    select_regions(event{210, 100});
+    REQUIRE(regions == std::vector<std::size_t>{2});
+    regions.clear();
+    select_regions.update(0, tarsier::region::rectangle(0, 0, 10, 10));
+    select_regions(event{0, 0});
+    select_regions(event{60, 60});
+    REQUIRE(regions == std::vector<std::size_t>{0});
+}
+
+TEST_CASE("Dispatch events to more than 64 regions", "[select_regions]") {
+    std::vector<tarsier::region> regions;
+    for (uint16_t index = 0; index < 100; ++index) {
+        regions.push_back(tarsier::region::rectangle(index, 0, 1, 1));
+    }
+    std::vector<std::size_t> dispatched_regions;
+    auto select_regions = tarsier::make_select_regions<event>(
+        320, 240, regions, [&](event, std::size_t region) { dispatched_regions.push_back(region); });
+    select_regions(event{10, 0});
+    select_regions(event{70, 0});
+    select_regions(event{99, 0});
+    select_regions(event{100, 0});
+    REQUIRE(dispatched_regions == std::vector<std::size_t>{10, 70, 99});
+}
@@ -0,0 +1,65 @@
+#include "../source/shed_load.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct shed_event {
+        uint64_t t;
+        float ratio;
+    };
+}
+
+TEST_CASE("Subsample events above the rate budget", "[shed_load]") {
+    for (auto strategy : {tarsier::shedding::thinning, tarsier::shedding::stratified}) {
+        std::size_t count = 0;
+        float ratio = 0.0f;
+        auto shed_load = tarsier::make_shed_load<event, shed_event>(
+            320,
+            240,
+            0.25f,
+            1000.0f,
+            100,
+            strategy,
+            [](event event, float ratio) -> shed_event {
+                return {event.t, ratio};
+            },
+            [&](shed_event shed_event) {
+                if (shed_event.t >= 10000) {
+                    ++count;
+                    ratio = shed_event.ratio;
+                }
+            });
+        for (uint64_t t = 0; t < 110000; ++t) {
+            shed_load(event{t, static_cast<uint16_t>(t % 16), static_cast<uint16_t>((t / 16) % 4)});
+        }
+        REQUIRE(std::abs(ratio - 0.25f) < 0.01f);
+        REQUIRE(std::abs(static_cast<float>(count) / 100000 - 0.25f) < 0.01f);
+    }
+}
+
+TEST_CASE("Propagate all the events below the rate budget", "[shed_load]") {
+    std::size_t count = 0;
+    auto shed_load = tarsier::make_shed_load<event, shed_event>(
+        320,
+        240,
+        0.25f,
+        1000.0f,
+        100,
+        tarsier::shedding::thinning,
+        [](event event, float ratio) -> shed_event {
+            return {event.t, ratio};
+        },
+        [&](shed_event shed_event) {
+            REQUIRE(shed_event.ratio == 1.0f);
+            ++count;
+        });
+    for (uint64_t t = 0; t < 100000; t += 10) {
+        shed_load(event{t, 0, 0});
+    }
+    REQUIRE(count == 10000);
+}
@@ -10,3 +10,9 @@ TEST_CASE("Shift the x coordinate", "[shift_x]") {
     shift_x(event{315});
     shift_x(event{200});
 }
+
+TEST_CASE("Shift the x coordinate with a compile-time geometry", "[shift_x]") {
+    auto shift_x = tarsier::make_shift_x<event, 320, 10>([](event event) -> void { REQUIRE(event.x == 210); });
+    shift_x(event{315});
+    shift_x(event{200});
+}
@@ -10,3 +10,9 @@ TEST_CASE("Shift the y coordinate", "[shift_y]") {
     shift_y(event{235});
     shift_y(event{135});
 }
+
+TEST_CASE("Shift the y coordinate with a compile-time geometry", "[shift_y]") {
+    auto shift_y = tarsier::make_shift_y<event, 240, 10>([](event event) -> void { REQUIRE(event.y == 145); });
+    shift_y(event{235});
+    shift_y(event{135});
+}
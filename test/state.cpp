@@ -0,0 +1,132 @@
+#include "../source/compute_activity.hpp"
+#include "../source/mask_isolated.hpp"
+#include "../source/track_blob.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
+
+namespace {
+    struct event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct blob {
+        float x;
+        float y;
+    };
+}
+
+TEST_CASE("Save and load per-pixel states", "[state]") {
+    std::vector<event> events;
+    uint32_t state = 1;
+    for (uint64_t t = 0; t < 20000; t += 5) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        events.push_back(event{t, static_cast<uint16_t>(state % 32), static_cast<uint16_t>((state >> 8) % 32)});
+    }
+    std::vector<event> expected_events;
+    auto mask_isolated =
+        tarsier::make_mask_isolated<event>(32, 32, 500, [&](event event) { expected_events.push_back(event); });
+    std::vector<float> expected_potentials;
+    auto compute_activity = tarsier::make_compute_activity<event, float>(
+        32,
+        32,
+        1000,
+        [](event, float potential) { return potential; },
+        [&](float potential) { expected_potentials.push_back(potential); });
+    std::stringstream stream;
+    for (std::size_t index = 0; index < events.size(); ++index) {
+        if (index == events.size() / 2) {
+            mask_isolated.save_state(stream);
+            compute_activity.save_state(stream);
+        }
+        mask_isolated(events[index]);
+        compute_activity(events[index]);
+    }
+    std::vector<event> restored_events;
+    auto restored_mask_isolated =
+        tarsier::make_mask_isolated<event>(32, 32, 500, [&](event event) { restored_events.push_back(event); });
+    restored_mask_isolated.load_state(stream);
+    std::vector<float> restored_potentials;
+    auto restored_compute_activity = tarsier::make_compute_activity<event, float>(
+        32,
+        32,
+        1000,
+        [](event, float potential) { return potential; },
+        [&](float potential) { restored_potentials.push_back(potential); });
+    restored_compute_activity.load_state(stream);
+    for (std::size_t index = events.size() / 2; index < events.size(); ++index) {
+        restored_mask_isolated(events[index]);
+        restored_compute_activity(events[index]);
+    }
+    REQUIRE(restored_events.size() > 0);
+    REQUIRE(
+        std::equal(
+            restored_events.begin(),
+            restored_events.end(),
+            expected_events.end() - restored_events.size(),
+            [](event first, event second) { return first.t == second.t && first.x == second.x; }));
+    REQUIRE(
+        std::equal(
+            restored_potentials.begin(),
+            restored_potentials.end(),
+            expected_potentials.begin() + events.size() / 2));
+}
+
+TEST_CASE("Save and load a tracker state", "[state]") {
+    blob last_blob{0.0f, 0.0f};
+    auto track_blob = tarsier::make_track_blob<event, blob>(
+        16,
+        16,
+        4,
+        0,
+        4,
+        0.9f,
+        0.9f,
+        [](event, float x, float y, float, float, float) -> blob { return {x, y}; },
+        [&](blob blob) { last_blob = blob; });
+    for (uint16_t index = 0; index < 20; ++index) {
+        track_blob(event{index, static_cast<uint16_t>(20 + index % 3), 18});
+    }
+    std::stringstream stream;
+    track_blob.save_state(stream);
+    REQUIRE(stream.str().size() % 8 == 0);
+    blob restored_blob{0.0f, 0.0f};
+    auto restored_track_blob = tarsier::make_track_blob<event, blob>(
+        0,
+        0,
+        1,
+        0,
+        1,
+        0.9f,
+        0.9f,
+        [](event, float x, float y, float, float, float) -> blob { return {x, y}; },
+        [&](blob blob) { restored_blob = blob; });
+    restored_track_blob.load_state(stream);
+    track_blob(event{20, 21, 19});
+    restored_track_blob(event{20, 21, 19});
+    REQUIRE(restored_blob.x == last_blob.x);
+    REQUIRE(restored_blob.y == last_blob.y);
+}
+
+TEST_CASE("Reject mismatched states", "[state]") {
+    auto mask_isolated = tarsier::make_mask_isolated<event>(32, 32, 500, [](event) {});
+    std::stringstream stream;
+    mask_isolated.save_state(stream);
+    auto smaller_mask_isolated = tarsier::make_mask_isolated<event>(16, 16, 500, [](event) {});
+    REQUIRE_THROWS_AS(smaller_mask_isolated.load_state(stream), std::runtime_error);
+    stream.clear();
+    stream.seekg(0);
+    auto compute_activity = tarsier::make_compute_activity<event, float>(
+        32,
+        32,
+        1000,
+        [](event, float potential) { return potential; },
+        [](float) {});
+    REQUIRE_THROWS_AS(compute_activity.load_state(stream), std::runtime_error);
+    std::stringstream truncated_stream(stream.str().substr(0, 100));
+    auto other_mask_isolated = tarsier::make_mask_isolated<event>(32, 32, 500, [](event) {});
+    REQUIRE_THROWS_AS(other_mask_isolated.load_state(truncated_stream), std::runtime_error);
+}
@@ -1,5 +1,6 @@
 #include "../source/stitch.hpp"
 #include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
 
 struct threshold_crossing {
     uint64_t t;
@@ -26,3 +27,48 @@ TEST_CASE("Stitch an threshold crossings stream", "[stitch]") {
     stitch(threshold_crossing{100, 200, 0, false});
     stitch(threshold_crossing{200, 200, 100, true});
 }
+
+TEST_CASE("Stitch threshold crossings whose timestamps wrap around the packed state", "[stitch]") {
+    std::vector<uint64_t> deltas_t;
+    auto stitch = tarsier::make_stitch<threshold_crossing, event>(
+        320,
+        240,
+        [](threshold_crossing threshold_crossing, uint64_t delta_t) -> event {
+            return {threshold_crossing.x, threshold_crossing.y, delta_t};
+        },
+        [&](event event) -> void { deltas_t.push_back(event.delta_t); });
+    stitch(threshold_crossing{(1ull << 31) - 100, 10, 20, false});
+    stitch(threshold_crossing{(1ull << 31) + 50, 10, 20, true});
+    stitch(threshold_crossing{(1ull << 40) + 10, 10, 20, true});
+    stitch(threshold_crossing{(1ull << 40) + 20, 10, 20, false});
+    stitch(threshold_crossing{(1ull << 40) + 30, 10, 20, false});
+    stitch(threshold_crossing{(1ull << 40) + 70, 10, 20, true});
+    REQUIRE(deltas_t == std::vector<uint64_t>({150, 40}));
+}
+
+TEST_CASE("Stitch threshold crossings into greyscale frames", "[stitch]") {
+    std::vector<std::vector<float>> frames;
+    auto stitch_frame = tarsier::make_stitch_frame<threshold_crossing, float>(
+        4,
+        3,
+        1000,
+        [](threshold_crossing, uint64_t delta_t) -> float { return 1000.0f / delta_t; },
+        [&](const std::vector<float>& frame) -> void { frames.push_back(frame); });
+    stitch_frame(threshold_crossing{0, 1, 0, false});
+    stitch_frame(threshold_crossing{100, 1, 0, true});
+    stitch_frame(threshold_crossing{200, 2, 1, false});
+    stitch_frame(threshold_crossing{700, 2, 1, true});
+    REQUIRE(frames.empty());
+    // the first frame is passed before the first threshold crossing of the next period
+    stitch_frame(threshold_crossing{1000, 1, 0, false});
+    REQUIRE(frames.size() == 1);
+    REQUIRE(frames[0][1] == 10.0f);
+    REQUIRE(frames[0][6] == 2.0f);
+    REQUIRE(frames[0][0] == 0.0f);
+    // the pixels keep their grey levels in the next frame
+    stitch_frame(threshold_crossing{1500, 1, 0, true});
+    stitch_frame(threshold_crossing{2000, 3, 2, false});
+    REQUIRE(frames.size() == 2);
+    REQUIRE(frames[1][1] == 2.0f);
+    REQUIRE(frames[1][6] == 2.0f);
+}
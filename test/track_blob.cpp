@@ -1,18 +1,21 @@
 #include "../source/track_blob.hpp"
 #include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
 
-struct event {
-    uint16_t x;
-    uint16_t y;
-};
+namespace {
+    struct event {
+        uint16_t x;
+        uint16_t y;
+    };
 
-struct blob {
-    float x;
-    float y;
-    float sigma_x_squared;
-    float sigma_xy;
-    float sigma_y_squared;
-};
+    struct blob {
+        float x;
+        float y;
+        float sigma_x_squared;
+        float sigma_xy;
+        float sigma_y_squared;
+    };
+}
 
 TEST_CASE("Average the events with a Gaussian blob", "[track_blob]") {
     blob expected_blob{0.2f, 0.1f, 50.0f, 30.0f, 10.0f};
@@ -46,3 +49,38 @@ TEST_CASE("Average the events with a Gaussian blob", "[track_blob]") {
     track_blob(event{0, 0});
     track_blob(event{200, 100});
 }
+
+namespace {
+    struct timestamped_event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+}
+
+TEST_CASE("Average the events with a Gaussian blob over time", "[track_blob]") {
+    std::vector<blob> blobs;
+    auto track_blob = tarsier::make_temporal_track_blob<timestamped_event, blob>(
+        0.0f,
+        0.0f,
+        10.0f,
+        0.0f,
+        10.0f,
+        1000.0f,
+        2000.0f,
+        100,
+        [](timestamped_event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared)
+            -> blob {
+            return {x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+        },
+        [&](blob blob) -> void { blobs.push_back(blob); });
+    for (uint64_t t = 10; t <= 1000; t += 10) {
+        track_blob(timestamped_event{t, 20, 10});
+    }
+    // the blob is passed at t = 10, 110, ..., 910
+    REQUIRE(blobs.size() == 10);
+    REQUIRE(std::abs(track_blob.x() - 20.0f * (1.0f - std::exp(-1.0f))) < 1e-3f);
+    REQUIRE(std::abs(track_blob.y() - 10.0f * (1.0f - std::exp(-1.0f))) < 1e-3f);
+    REQUIRE(track_blob.sigma_xy() > 0.0f);
+    REQUIRE(blobs.back().x < track_blob.x());
+}
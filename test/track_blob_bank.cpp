@@ -0,0 +1,118 @@
+#include "../source/track_blob_bank.hpp"
+#include "../source/select_disk.hpp"
+#include "../source/track_blob.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+    struct Event {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct Blob {
+        std::size_t id;
+        float x;
+        float y;
+        float sigma_x_squared;
+        float sigma_xy;
+        float sigma_y_squared;
+    };
+}
+
+TEST_CASE("Average the events with a bank of gated Gaussian blobs", "[track_blob_bank]") {
+    std::vector<tarsier::gated_blob> gated_blobs;
+    for (uint16_t index = 0; index < 20; ++index) {
+        const auto x = static_cast<float>(index % 5) * 8.0f + 4.0f;
+        const auto y = static_cast<float>(index / 5) * 8.0f + 4.0f;
+        gated_blobs.push_back({x, y, 6.0f, x, y, 4.0f, 0.0f, 4.0f});
+    }
+    std::vector<Blob> blobs;
+    auto track_blob_bank = tarsier::make_track_blob_bank<Event, Blob>(
+        gated_blobs,
+        0.9f,
+        0.8f,
+        [](Event, std::size_t id, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared)
+            -> Blob {
+            return {id, x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+        },
+        [&](Blob blob) -> void { blobs.push_back(blob); });
+
+    // the expected blobs are produced by independent select_disk and track_blob pairs
+    std::vector<Blob> expected_blobs;
+    std::vector<std::function<void(Event)>> trackers;
+    for (std::size_t id = 0; id < gated_blobs.size(); ++id) {
+        const auto& gated_blob = gated_blobs[id];
+        auto track_blob = std::make_shared<tarsier::track_blob<
+            Event,
+            Blob,
+            std::function<Blob(Event, float, float, float, float, float)>,
+            std::function<void(Blob)>>>(
+            gated_blob.x,
+            gated_blob.y,
+            gated_blob.sigma_x_squared,
+            gated_blob.sigma_xy,
+            gated_blob.sigma_y_squared,
+            0.9f,
+            0.8f,
+            [id](Event, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared) -> Blob {
+                return {id, x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+            },
+            [&](Blob blob) -> void { expected_blobs.push_back(blob); });
+        auto select_disk = std::make_shared<tarsier::select_disk<Event, std::function<void(Event)>>>(
+            gated_blob.gate_x, gated_blob.gate_y, gated_blob.gate_radius, [track_blob](Event event) -> void {
+                (*track_blob)(event);
+            });
+        trackers.push_back([select_disk](Event event) -> void { (*select_disk)(event); });
+    }
+    std::mt19937 engine(42);
+    std::uniform_int_distribution<uint16_t> x_distribution(0, 40);
+    std::uniform_int_distribution<uint16_t> y_distribution(0, 32);
+    std::vector<Event> events;
+    for (uint64_t t = 0; t < 1000; ++t) {
+        events.push_back(Event{t, x_distribution(engine), y_distribution(engine)});
+    }
+    for (std::size_t index = 0; index < events.size() / 2; ++index) {
+        track_blob_bank(events[index]);
+    }
+    track_blob_bank(events.data() + events.size() / 2, events.data() + events.size());
+    for (auto event : events) {
+        for (auto& tracker : trackers) {
+            tracker(event);
+        }
+    }
+    REQUIRE(blobs.size() == expected_blobs.size());
+    for (std::size_t index = 0; index < blobs.size(); ++index) {
+        REQUIRE(blobs[index].id == expected_blobs[index].id);
+        REQUIRE(std::abs(blobs[index].x - expected_blobs[index].x) < 1e-3f);
+        REQUIRE(std::abs(blobs[index].y - expected_blobs[index].y) < 1e-3f);
+        REQUIRE(std::abs(blobs[index].sigma_x_squared - expected_blobs[index].sigma_x_squared) < 1e-3f);
+        REQUIRE(std::abs(blobs[index].sigma_xy - expected_blobs[index].sigma_xy) < 1e-3f);
+        REQUIRE(std::abs(blobs[index].sigma_y_squared - expected_blobs[index].sigma_y_squared) < 1e-3f);
+    }
+    REQUIRE(track_blob_bank.x(blobs.back().id) == blobs.back().x);
+    REQUIRE(track_blob_bank.sigma_y_squared(blobs.back().id) == blobs.back().sigma_y_squared);
+
+    // the state round-trips through a bank with the same gates
+    std::stringstream stream;
+    track_blob_bank.save_state(stream);
+    auto restored_bank = tarsier::make_track_blob_bank<Event, Blob>(
+        gated_blobs,
+        0.9f,
+        0.8f,
+        [](Event, std::size_t id, float x, float y, float sigma_x_squared, float sigma_xy, float sigma_y_squared)
+            -> Blob {
+            return {id, x, y, sigma_x_squared, sigma_xy, sigma_y_squared};
+        },
+        [](Blob) -> void {});
+    restored_bank.load_state(stream);
+    for (std::size_t id = 0; id < gated_blobs.size(); ++id) {
+        REQUIRE(restored_bank.x(id) == track_blob_bank.x(id));
+        REQUIRE(restored_bank.sigma_xy(id) == track_blob_bank.sigma_xy(id));
+    }
+}
@@ -1,72 +1,209 @@
 #include "../source/track_blob_multi.hpp"
 #include "../third_party/Catch2/single_include/catch.hpp"
+#include <sstream>
 #include <vector>
-struct Event {
-    uint16_t x;
-    uint16_t y;
-};
 
-struct Blob {
-    float x;
-    float y;
-    float sigma_x_squared;
-    float sigma_xy;
-    float sigma_y_squared;
-};
+namespace {
+    struct Event {
+        uint16_t x;
+        uint16_t y;
+    };
 
-struct MultiBlobs {
-    uint16_t id;
-    std::vector<Blob> blobs;
-};
+    struct TimestampedEvent {
+        uint64_t t;
+        uint16_t x;
+        uint16_t y;
+    };
+
+    struct Blob {
+        float x;
+        float y;
+        float sigma_x_squared;
+        float sigma_xy;
+        float sigma_y_squared;
+    };
+
+    struct MultiBlobs {
+        uint16_t id;
+        std::vector<Blob> blobs;
+    };
+
+    struct BlobChange {
+        uint16_t id;
+        tarsier::blob_status status;
+        Blob blob;
+    };
+}
 
 TEST_CASE("Average the events with multiple Gaussian blobs", "[track_blob_multi]") {
     MultiBlobs multi_blobs_initial{0, {{2.0f, 2.0f, 0.16f, 0.0f, 0.16f},
                                        {7.0f, 2.0f, 0.16f, 0.0f, 0.16f}}};
-    MultiBlobs expected_multi_blobs_0{0, {{2.5f, 2.5f, 0.58f, 0.5f, 0.58f},
-                                          {7.0f, 2.0f, 0.16f, 0.0f, 0.16f}}};
-    MultiBlobs expected_multi_blobs_1{1, {{2.5f, 2.5f, 0.58f, 0.5f, 0.58f},
-                                          {7.5f, 2.5f, 0.58f, 0.5f, 0.58f}}};
+    std::vector<BlobChange> expected_changes{
+        {0, tarsier::blob_status::update, {2.5f, 2.5f, 0.58f, 0.5f, 0.58f}},
+        {1, tarsier::blob_status::update, {7.5f, 2.5f, 0.58f, 0.5f, 0.58f}},
+    };
 
-    auto first_received = false;
+    std::size_t index = 0;
     auto track_blob_multi = tarsier::make_track_blob_multi<Event, MultiBlobs>(
         multi_blobs_initial,
         0.001f,
         0.5f,
         0.5f,
-        [](Event event, MultiBlobs multi_blobs) -> MultiBlobs { return {multi_blobs}; },
-        [&](MultiBlobs multi_blobs) -> void {
-            if (first_received) {
-                REQUIRE(multi_blobs.id == expected_multi_blobs_1.id);
+        [](Event, uint16_t id, tarsier::blob_status status, const Blob& blob) -> BlobChange {
+            return {id, status, blob};
+        },
+        [&](BlobChange change) -> void {
+            REQUIRE(index < expected_changes.size());
+            const auto& expected = expected_changes[index];
+            REQUIRE(change.id == expected.id);
+            REQUIRE(change.status == expected.status);
+            REQUIRE(std::abs(change.blob.x - expected.blob.x) / expected.blob.x < 1e-3f);
+            REQUIRE(std::abs(change.blob.y - expected.blob.y) / expected.blob.y < 1e-3f);
+            REQUIRE(std::abs(change.blob.sigma_x_squared - expected.blob.sigma_x_squared) / expected.blob.sigma_x_squared < 1e-3f);
+            REQUIRE(std::abs(change.blob.sigma_xy - expected.blob.sigma_xy) / (expected.blob.sigma_xy + 1e-3f) < 1e-3f);
+            REQUIRE(std::abs(change.blob.sigma_y_squared - expected.blob.sigma_y_squared) / expected.blob.sigma_y_squared < 1e-3f);
+            ++index;
+        });
+    track_blob_multi(Event{3, 3});
+    track_blob_multi(Event{8, 3});
+    REQUIRE(index == expected_changes.size());
+}
 
-                REQUIRE(std::abs(multi_blobs.blobs[0].x - expected_multi_blobs_1.blobs[0].x) / expected_multi_blobs_1.blobs[0].x < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].y - expected_multi_blobs_1.blobs[0].y) / expected_multi_blobs_1.blobs[0].y < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].sigma_x_squared - expected_multi_blobs_1.blobs[0].sigma_x_squared) / expected_multi_blobs_1.blobs[0].sigma_x_squared < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].sigma_xy - expected_multi_blobs_1.blobs[0].sigma_xy) / (expected_multi_blobs_1.blobs[0].sigma_xy + 1e-3f) < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].sigma_y_squared - expected_multi_blobs_1.blobs[0].sigma_y_squared) / expected_multi_blobs_1.blobs[0].sigma_y_squared < 1e-3f);
+TEST_CASE("Spawn and remove Gaussian blobs", "[track_blob_multi]") {
+    std::vector<BlobChange> changes;
+    auto track_blob_multi = tarsier::make_track_blob_multi<TimestampedEvent, MultiBlobs>(
+        MultiBlobs{0, {{2.0f, 2.0f, 1.0f, 0.0f, 1.0f}}},
+        0.001f,
+        0.9f,
+        0.9f,
+        tarsier::blob_lifecycle{4, 1000.0f, 0.5f, 3, 2.0f, 1000, 1.0f, 1.0f},
+        0,
+        [](TimestampedEvent, uint16_t id, tarsier::blob_status status, const Blob& blob) -> BlobChange {
+            return {id, status, blob};
+        },
+        [&](BlobChange change) -> void { changes.push_back(change); });
+    REQUIRE(track_blob_multi.alive(0));
+    REQUIRE(!track_blob_multi.alive(1));
+    track_blob_multi(TimestampedEvent{0, 2, 2});
+    REQUIRE(changes.size() == 1);
+    REQUIRE(changes.back().status == tarsier::blob_status::update);
 
-                REQUIRE(std::abs(multi_blobs.blobs[1].x - expected_multi_blobs_1.blobs[1].x) / expected_multi_blobs_1.blobs[1].x < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].y - expected_multi_blobs_1.blobs[1].y) / expected_multi_blobs_1.blobs[1].y < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].sigma_x_squared - expected_multi_blobs_1.blobs[1].sigma_x_squared) / expected_multi_blobs_1.blobs[1].sigma_x_squared < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].sigma_xy - expected_multi_blobs_1.blobs[1].sigma_xy) / (expected_multi_blobs_1.blobs[1].sigma_xy + 1e-3f) < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].sigma_y_squared - expected_multi_blobs_1.blobs[1].sigma_y_squared) / expected_multi_blobs_1.blobs[1].sigma_y_squared < 1e-3f);
-            } else {
-                REQUIRE(multi_blobs.id == expected_multi_blobs_0.id);
+    // three close unassigned events spawn a blob in the first free slot
+    track_blob_multi(TimestampedEvent{10, 20, 20});
+    track_blob_multi(TimestampedEvent{20, 21, 20});
+    REQUIRE(changes.size() == 1);
+    REQUIRE(!track_blob_multi.alive(1));
+    track_blob_multi(TimestampedEvent{30, 20, 21});
+    REQUIRE(track_blob_multi.alive(1));
+    REQUIRE(track_blob_multi.alive_ids().size() == 2);
+    REQUIRE(std::abs(track_blob_multi.activity(1, 30) - 3.0f) < 1e-3f);
+    REQUIRE(changes.size() == 2);
+    REQUIRE(changes.back().id == 1);
+    REQUIRE(changes.back().status == tarsier::blob_status::spawn);
+    REQUIRE(std::abs(changes.back().blob.x - 61.0f / 3.0f) < 1e-3f);
 
-                REQUIRE(std::abs(multi_blobs.blobs[0].x - expected_multi_blobs_0.blobs[0].x) / expected_multi_blobs_0.blobs[0].x < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].y - expected_multi_blobs_0.blobs[0].y) / expected_multi_blobs_0.blobs[0].y < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].sigma_x_squared - expected_multi_blobs_0.blobs[0].sigma_x_squared) / expected_multi_blobs_0.blobs[0].sigma_x_squared < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].sigma_xy - expected_multi_blobs_0.blobs[0].sigma_xy) / (expected_multi_blobs_0.blobs[0].sigma_xy + 1e-3f) < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[0].sigma_y_squared - expected_multi_blobs_0.blobs[0].sigma_y_squared) / expected_multi_blobs_0.blobs[0].sigma_y_squared < 1e-3f);
+    // the first blob's activity (4) falls below 0.5 after 1000 * log(8) ~= 2079 timestamp units
+    for (uint64_t t = 500; t <= 2000; t += 500) {
+        track_blob_multi(TimestampedEvent{t, 20, 20});
+    }
+    REQUIRE(track_blob_multi.alive(0));
+    REQUIRE(changes.size() == 6);
+    track_blob_multi(TimestampedEvent{2100, 20, 20});
+    REQUIRE(!track_blob_multi.alive(0));
+    REQUIRE(track_blob_multi.alive(1));
+    REQUIRE(track_blob_multi.alive_ids().size() == 1);
+    REQUIRE(changes.size() == 8);
+    REQUIRE(changes[6].id == 0);
+    REQUIRE(changes[6].status == tarsier::blob_status::kill);
+    REQUIRE(changes[7].id == 1);
+    REQUIRE(changes[7].status == tarsier::blob_status::update);
 
-                REQUIRE(std::abs(multi_blobs.blobs[1].x - expected_multi_blobs_0.blobs[1].x) / expected_multi_blobs_0.blobs[1].x < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].y - expected_multi_blobs_0.blobs[1].y) / expected_multi_blobs_0.blobs[1].y < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].sigma_x_squared - expected_multi_blobs_0.blobs[1].sigma_x_squared) / expected_multi_blobs_0.blobs[1].sigma_x_squared < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].sigma_xy - expected_multi_blobs_0.blobs[1].sigma_xy) / (expected_multi_blobs_0.blobs[1].sigma_xy + 1e-3f) < 1e-3f);
-                REQUIRE(std::abs(multi_blobs.blobs[1].sigma_y_squared - expected_multi_blobs_0.blobs[1].sigma_y_squared) / expected_multi_blobs_0.blobs[1].sigma_y_squared < 1e-3f);
+    // the lifecycle state round-trips through a tracker with the same parameters
+    std::stringstream stream;
+    track_blob_multi.save_state(stream);
+    auto restored_track_blob_multi = tarsier::make_track_blob_multi<TimestampedEvent, MultiBlobs>(
+        MultiBlobs{0, {{2.0f, 2.0f, 1.0f, 0.0f, 1.0f}}},
+        0.001f,
+        0.9f,
+        0.9f,
+        tarsier::blob_lifecycle{4, 1000.0f, 0.5f, 3, 2.0f, 1000, 1.0f, 1.0f},
+        0,
+        [](TimestampedEvent, uint16_t id, tarsier::blob_status status, const Blob& blob) -> BlobChange {
+            return {id, status, blob};
+        },
+        [](BlobChange) -> void {});
+    restored_track_blob_multi.load_state(stream);
+    REQUIRE(!restored_track_blob_multi.alive(0));
+    REQUIRE(restored_track_blob_multi.alive(1));
+    REQUIRE(restored_track_blob_multi.activity(1, 2500) == track_blob_multi.activity(1, 2500));
+}
 
-                first_received = true;
-            }
-        });
-    track_blob_multi(Event{3, 3});
-    track_blob_multi(Event{8, 3});
+TEST_CASE("Merge overlapping Gaussian blobs", "[track_blob_multi]") {
+    std::vector<BlobChange> changes;
+    auto track_blob_multi = tarsier::make_track_blob_multi<TimestampedEvent, MultiBlobs>(
+        MultiBlobs{0, {{5.0f, 5.0f, 1.0f, 0.0f, 1.0f}, {6.8f, 5.0f, 1.0f, 0.0f, 1.0f}}},
+        0.001f,
+        0.5f,
+        0.5f,
+        tarsier::blob_lifecycle{2, 0.0f, 0.0f, 0, 0.0f, 0, 0.0f, 1.5f},
+        0,
+        [](TimestampedEvent, uint16_t id, tarsier::blob_status status, const Blob& blob) -> BlobChange {
+            return {id, status, blob};
+        },
+        [&](BlobChange change) -> void { changes.push_back(change); });
+
+    // the second blob moves to x = 6.4, close enough to the first one to absorb it
+    track_blob_multi(TimestampedEvent{0, 6, 5});
+    REQUIRE(track_blob_multi.alive_ids().size() == 1);
+    REQUIRE(track_blob_multi.alive(1));
+    REQUIRE(std::abs(track_blob_multi.activity(1, 0) - 3.0f) < 1e-3f);
+    REQUIRE(changes.size() == 2);
+    REQUIRE(changes[0].id == 0);
+    REQUIRE(changes[0].status == tarsier::blob_status::kill);
+    REQUIRE(changes[1].id == 1);
+    REQUIRE(changes[1].status == tarsier::blob_status::update);
+    // the merged center is the activity-weighted mean of the centers
+    REQUIRE(std::abs(changes[1].blob.x - (6.4f * 2.0f + 5.0f) / 3.0f) < 1e-3f);
+}
+
+TEST_CASE("Snapshot the Gaussian blobs periodically", "[track_blob_multi]") {
+    std::vector<BlobChange> changes;
+    auto track_blob_multi = tarsier::make_track_blob_multi<TimestampedEvent, MultiBlobs>(
+        MultiBlobs{0, {{2.0f, 2.0f, 0.16f, 0.0f, 0.16f}, {7.0f, 2.0f, 0.16f, 0.0f, 0.16f}}},
+        0.001f,
+        0.5f,
+        0.5f,
+        tarsier::blob_lifecycle{2, 0.0f, 0.0f, 0, 0.0f, 0, 0.0f, 0.0f},
+        100,
+        [](TimestampedEvent, uint16_t id, tarsier::blob_status status, const Blob& blob) -> BlobChange {
+            return {id, status, blob};
+        },
+        [&](BlobChange change) -> void { changes.push_back(change); });
+    track_blob_multi(TimestampedEvent{0, 3, 3});
+    REQUIRE(changes.size() == 3);
+    REQUIRE(changes[1].status == tarsier::blob_status::snapshot);
+    REQUIRE(changes[2].status == tarsier::blob_status::snapshot);
+    REQUIRE(changes[1].id != changes[2].id);
+    track_blob_multi(TimestampedEvent{50, 8, 3});
+    REQUIRE(changes.size() == 4);
+    track_blob_multi(TimestampedEvent{100, 8, 3});
+    REQUIRE(changes.size() == 7);
+    REQUIRE(changes[5].status == tarsier::blob_status::snapshot);
+}
+
+TEST_CASE("Reject a decaying lifecycle for events without timestamps", "[track_blob_multi]") {
+    const auto make = []() {
+        tarsier::make_track_blob_multi<Event, MultiBlobs>(
+            MultiBlobs{0, {{2.0f, 2.0f, 1.0f, 0.0f, 1.0f}}},
+            0.001f,
+            0.9f,
+            0.9f,
+            tarsier::blob_lifecycle{4, 1000.0f, 0.5f, 0, 0.0f, 0, 0.0f, 0.0f},
+            0,
+            [](Event, uint16_t id, tarsier::blob_status status, const Blob& blob) -> BlobChange {
+                return {id, status, blob};
+            },
+            [](BlobChange) -> void {});
+    };
+    REQUIRE_THROWS_AS(make(), std::logic_error);
 }
@@ -0,0 +1,41 @@
+#include "../source/mirror_x.hpp"
+#include "../source/mirror_y.hpp"
+#include "../source/select_rectangle.hpp"
+#include "../source/shift_x.hpp"
+#include "../source/shift_y.hpp"
+#include "../source/transform_geometry.hpp"
+#include "../third_party/Catch2/single_include/catch.hpp"
+#include <vector>
+
+namespace {
+    struct event {
+        uint16_t x;
+        uint16_t y;
+    };
+}
+
+TEST_CASE("Apply a composed geometric transform", "[transform_geometry]") {
+    std::vector<event> expected_events;
+    auto shift_y = tarsier::make_shift_y<event>(40, -3, [&](event event) { expected_events.push_back(event); });
+    auto transpose = [&](event original) { shift_y(event{original.y, original.x}); };
+    auto mirror_y = tarsier::make_mirror_y<event>(30, [&](event event) { transpose(event); });
+    auto shift_x = tarsier::make_shift_x<event>(40, 7, [&](event event) { mirror_y(event); });
+    auto select_rectangle =
+        tarsier::make_select_rectangle<event>(5, 8, 30, 15, [&](event event) { shift_x(event); });
+    std::vector<event> events;
+    auto transform_geometry = tarsier::make_transform_geometry<event>(
+        tarsier::geometry(40, 30).crop(5, 8, 30, 15).shift_x(7).mirror_y().transpose().shift_y(-3),
+        [&](event event) { events.push_back(event); });
+    for (uint16_t y = 0; y < 30; ++y) {
+        for (uint16_t x = 0; x < 40; ++x) {
+            select_rectangle(event{x, y});
+            transform_geometry(event{x, y});
+        }
+    }
+    REQUIRE(!expected_events.empty());
+    REQUIRE(events.size() == expected_events.size());
+    for (std::size_t index = 0; index < events.size(); ++index) {
+        REQUIRE(events[index].x == expected_events[index].x);
+        REQUIRE(events[index].y == expected_events[index].y);
+    }
+}